@@ -0,0 +1,104 @@
+/*
+ * Compares parsing through AbstractArgument's virtual parseArg with parsing
+ * through an ArgumentList, which calls each argument's parseArg directly.
+ *
+ * Both parsers declare the same arguments and parse the same command line.
+ * Constructing a parser is timed on its own as well, so the cost of
+ * dispatch is the difference between the two timings of each parser.
+ *
+ * Build and run from the repository root:
+ *	g++ -std=c++20 -O2 -DNDEBUG -I. -o dispatch bench/dispatch.cpp
+ *	./dispatch [iterations]
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+
+#include "targ.hpp"
+#include "unix.hpp"
+
+struct Options : targ::UnixParser {
+	targ::Switch verbose{this, 'v', "verbose", "Show verbose output"};
+	targ::Switch quiet{this, 'q', "quiet", "Show less output"};
+	targ::Switch force{this, 'f', "force", "Overwrite files"};
+	targ::Switch recursive{this, 'r', "recursive", "Descend into directories"};
+	targ::Switch dryRun{this, "dry-run", "Only show what would be done"};
+	targ::Option<int> jobs{this, 'j', "jobs", "Number of jobs"};
+	targ::Option<int> level{this, 'l', "level", "Compression level"};
+	targ::Option<long> limit{this, "limit", "Size limit"};
+	targ::Option<double> ratio{this, "ratio", "Target ratio"};
+	targ::Option<double> timeout{this, 't', "timeout", "Timeout in seconds"};
+	targ::Option<std::string_view> output{this, 'o', "output", "Output file"};
+	targ::Option<std::string_view> format{this, "format", "Output format"};
+	targ::Option<std::string_view> config{this, 'c', "config", "Configuration file"};
+	targ::Option<std::vector<int>> ports{this, 'p', "ports", "Ports to use"};
+	targ::Option<std::vector<std::string_view>> include{this, 'I', "include", "Include directories"};
+	targ::PositionalArgument<std::vector<std::string_view>> files{this, "files", "Input files"};
+};
+
+struct Virtual : Options {};
+
+struct Listed : Options {
+	using arguments = targ::ArgumentList<&Listed::verbose, &Listed::quiet, &Listed::force, &Listed::recursive,
+		&Listed::dryRun, &Listed::jobs, &Listed::level, &Listed::limit, &Listed::ratio, &Listed::timeout,
+		&Listed::output, &Listed::format, &Listed::config, &Listed::ports, &Listed::include, &Listed::files>;
+};
+
+static const std::string_view commandLine[] = {
+	"-vfr", "--dry-run", "-j", "8", "--level=9", "--limit", "64M", "--ratio", "0.75", "-t", "1.5",
+	"-o", "out.tar", "--format", "tar", "--config=build.conf", "-p", "80", "443", "8080",
+	"-I", "include", "src", "third_party/include", "--quiet", "-l", "3", "--jobs", "16",
+	"--ports", "22", "-I", "/usr/include", "--", "a.c", "b.c", "c.c", "d.c", "e.c", "f.c"
+};
+
+template <typename P>
+static double timeConstruction(long iterations, std::size_t &sink) {
+	auto start = std::chrono::steady_clock::now();
+
+	for (long i = 0; i < iterations; ++i) {
+		P parser;
+		sink += parser.isPresent(parser.verbose);
+	}
+
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / iterations;
+}
+
+template <typename P>
+static double timeParse(long iterations, std::size_t &sink) {
+	auto start = std::chrono::steady_clock::now();
+
+	for (long i = 0; i < iterations; ++i) {
+		P parser;
+		targ::parse(parser, commandLine);
+		sink += parser.isPresent(parser.verbose) + parser.isPresent(parser.files);
+	}
+
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / iterations;
+}
+
+template <typename P>
+static void report(const char *name, long iterations, std::size_t &sink) {
+	// Warm up caches and the branch predictors first
+	timeParse<P>(iterations / 10 + 1, sink);
+
+	double construction = timeConstruction<P>(iterations, sink);
+	double total = timeParse<P>(iterations, sink);
+
+	std::printf("%-10s %10.1f ns/parse %10.1f ns construction %10.1f ns dispatch\n",
+		name, total, construction, total - construction);
+}
+
+int main(int argc, char **argv) {
+	long iterations = argc > 1 ? std::atol(argv[1]) : 200000;
+	std::size_t sink = 0;
+
+	std::printf("%ld iterations of %zu arguments\n", iterations, std::size(commandLine));
+	report<Virtual>("virtual", iterations, sink);
+	report<Listed>("listed", iterations, sink);
+
+	return sink == 0;
+}
@@ -5,7 +5,7 @@ struct SampleParser : public targ::UnixParser {
 	targ::Switch assemblyOut{this, 'S', "Compile but do not assemble"};
 	targ::Switch verbose{this, 'v', "verbose", "Show verbose output"};
 
-	targ::Option<std::string> lang{this, 'x', "Set the language"};
+	targ::Option<std::string_view> lang{this, 'x', "Set the language"};
 	targ::Option<std::string> arch{this, "arch", "Set the target architecture"};
 	targ::Option<std::string> outFilePath{this, 'o', "output", "Set the output file"};
 	targ::Option<std::vector<std::string>> multiple{this, 'm', "multiple", "multiple arguments"};
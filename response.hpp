@@ -0,0 +1,297 @@
+/*
+ * Response files: arguments read from a file named by @file, as gcc and
+ * MSVC accept them
+ */
+#ifndef _TARG_RESPONSE_HPP_
+#define _TARG_RESPONSE_HPP_
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if __has_include(<sys/mman.h>)
+#define TARG_HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <filesystem>
+#endif
+
+#include "targ.hpp"
+
+namespace targ {
+	namespace detail {
+		/*
+		 * A response file, mapped privately into memory. Pages are only read
+		 * as the tokenizer reaches them, and the mapping is copy on write, so
+		 * tokens can be unquoted in place without touching the file. Pipes and
+		 * devices, such as the file of bash's <(...), can't be mapped, so they
+		 * are read into a buffer instead.
+		 */
+		class MappedFile {
+		private:
+			char *begin = nullptr;
+			std::size_t length = 0;
+			bool mapped = false;
+			std::pmr::vector<char> buffer;
+
+			// Read the whole of a file which can't be mapped
+			template <typename F>
+			void readAll(F read) {
+				for (std::size_t n = 0; ; ) {
+					buffer.resize(n + 4096);
+
+					std::size_t got = read(buffer.data() + n, buffer.size() - n);
+					if (got == 0) {
+						buffer.resize(n);
+						break;
+					}
+
+					n += got;
+				}
+
+				begin = buffer.data();
+				length = buffer.size();
+			}
+
+		public:
+			// Identifies the file, however it was named, for cycle detection
+			std::pair<std::uintmax_t, std::uintmax_t> identity;
+
+			/*
+			 * Map a file
+			 *
+			 * path		The path of the file
+			 * resource	Allocates the buffer for files which can't be mapped
+			 * Throws ParsingError if the file can't be read.
+			 */
+			MappedFile(const std::string &path, std::pmr::memory_resource *resource) : buffer(resource) {
+#ifdef TARG_HAVE_MMAP
+				int fd = ::open(path.c_str(), O_RDONLY);
+				struct stat info;
+
+				if (fd < 0 || ::fstat(fd, &info) != 0) {
+					if (fd >= 0) ::close(fd);
+					throw ParsingError("Can't read response file " + path);
+				}
+
+				identity = {info.st_dev, info.st_ino};
+
+				if (!S_ISREG(info.st_mode)) {
+					bool failed = false;
+
+					readAll([&](char *p, std::size_t n) -> std::size_t {
+						ssize_t got;
+						do got = ::read(fd, p, n); while (got < 0 && errno == EINTR);
+
+						failed = got < 0;
+						return failed ? 0 : got;
+					});
+
+					::close(fd);
+					if (failed) throw ParsingError("Can't read response file " + path);
+					return;
+				}
+
+				length = info.st_size;
+
+				if (length) {
+					void *p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+					if (p == MAP_FAILED) {
+						::close(fd);
+						throw ParsingError("Can't read response file " + path);
+					}
+
+					begin = static_cast<char *>(p);
+					mapped = true;
+					::madvise(p, length, MADV_SEQUENTIAL);
+				}
+
+				::close(fd);
+#else
+				std::FILE *file = std::fopen(path.c_str(), "rb");
+				if (!file) throw ParsingError("Can't read response file " + path);
+
+				// Pipes may have no canonical path, so they're known by name
+				std::error_code ec;
+				std::filesystem::path canonical = std::filesystem::canonical(path, ec);
+				if (ec) canonical = path;
+
+				identity = {std::hash<std::filesystem::path::string_type>()(canonical.native()), 0};
+				readAll([&](char *p, std::size_t n) { return std::fread(p, 1, n, file); });
+
+				bool failed = std::ferror(file);
+				std::fclose(file);
+				if (failed) throw ParsingError("Can't read response file " + path);
+#endif
+			}
+
+			MappedFile(const MappedFile &) = delete;
+			MappedFile &operator=(const MappedFile &) = delete;
+
+			~MappedFile() {
+#ifdef TARG_HAVE_MMAP
+				if (mapped) ::munmap(begin, length);
+#endif
+			}
+
+			char *data() const { return begin; }
+			std::size_t size() const { return length; }
+		};
+
+		/*
+		 * Splits the contents of a response file into arguments as it goes,
+		 * with shell-like quoting: arguments are separated by whitespace, text
+		 * in single quotes is literal, and a backslash escapes the next
+		 * character, except inside single quotes. Inside double quotes a
+		 * backslash only escapes '"' and '\'. A backslash at the end of a line
+		 * continues it.
+		 *
+		 * Quotes and escapes are removed by moving the rest of the argument
+		 * back over them, so each argument is a view of the buffer and nothing
+		 * is allocated. Only arguments which contain quotes or escapes are
+		 * written to.
+		 */
+		class ResponseTokenizer {
+		private:
+			char *pos;
+			char *end;
+
+			static bool isSpace(char c) {
+				return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+			}
+
+			bool atLineContinuation() const {
+				return *pos == '\\' && pos + 1 != end && pos[1] == '\n';
+			}
+
+		public:
+			ResponseTokenizer(char *data, std::size_t size) : pos(data), end(data + size) {}
+
+			/*
+			 * Read the next argument
+			 *
+			 * token	Set to the argument
+			 * Returns false if there are no more arguments.
+			 * Throws ParsingError if a quote isn't closed.
+			 */
+			bool next(std::string_view &token) {
+				while (pos != end && (isSpace(*pos) || atLineContinuation())) pos += 1 + (*pos == '\\');
+				if (pos == end) return false;
+
+				char *start = pos;
+				char *out = pos;
+				char quote = '\0';
+
+				for (; pos != end && (quote || !isSpace(*pos)); ++pos) {
+					char c = *pos;
+
+					if (quote == '\'') {
+						if (c == '\'') { quote = '\0'; continue; }
+					} else if (atLineContinuation()) {
+						// A backslash at the end of a line joins it to the next
+						++pos;
+						continue;
+					} else if (c == '\\' && pos + 1 != end
+							&& (!quote || pos[1] == '"' || pos[1] == '\\')) {
+						c = *++pos;
+					} else if (c == '"' && (!quote || quote == '"')) {
+						quote = quote ? '\0' : '"';
+						continue;
+					} else if (c == '\'' && !quote) {
+						quote = '\'';
+						continue;
+					}
+
+					if (out != pos) *out = c;
+					++out;
+				}
+
+				if (quote) throw ParsingError("Unterminated quote in response file");
+
+				token = std::string_view(start, out - start);
+				return true;
+			}
+		};
+
+		/*
+		 * Add a command line argument to a list of tokens, expanding it if it
+		 * names a response file (@file). Response files may name other
+		 * response files, but not themselves, directly or indirectly.
+		 *
+		 * arg		The argument
+		 * tokens	The list to add to
+		 * files	Keeps each mapped file alive for as long as the views of it
+		 * chain	The identities of the response files being expanded
+		 * Throws ParsingError if a response file can't be read or includes
+		 * itself.
+		 */
+		inline void expandResponseFile(std::string_view arg, std::pmr::vector<std::string_view> &tokens,
+				std::pmr::vector<std::shared_ptr<void>> &files,
+				std::pmr::vector<std::pair<std::uintmax_t, std::uintmax_t>> &chain) {
+			if (arg.size() < 2 || arg[0] != '@') {
+				tokens.push_back(arg);
+				return;
+			}
+
+			std::string path(arg.substr(1));
+			std::pmr::polymorphic_allocator<> allocator(files.get_allocator());
+			std::shared_ptr<MappedFile> file = std::allocate_shared<MappedFile>(allocator, path, allocator.resource());
+
+			if (std::ranges::find(chain, file->identity) != chain.end()) {
+				throw ParsingError("Response file " + path + " includes itself");
+			}
+
+			files.push_back(file);
+			chain.push_back(file->identity);
+
+			ResponseTokenizer tokenizer(file->data(), file->size());
+			for (std::string_view token; tokenizer.next(token); ) {
+				expandResponseFile(token, tokens, files, chain);
+			}
+
+			chain.pop_back();
+		}
+	}
+
+	/*
+	 * Replace an argument @file with the arguments in the file. Response
+	 * files may name other response files, but not themselves, directly or
+	 * indirectly. Other arguments are kept as they are. A parser reads
+	 * response files if its expandArgument is set to this:
+	 *	struct MyParser : targ::UnixParser {
+	 *		MyParser() { expandArgument = targ::expandResponseFiles; }
+	 *	};
+	 *
+	 * Each file is mapped privately into memory, and the arguments are views
+	 * of the mapping, which retained keeps for as long as the parser.
+	 *
+	 * arg			The argument
+	 * args			The list to add the arguments to
+	 * retained		Keeps each file alive for as long as the views of it
+	 * Throws ParsingError if a response file can't be read or includes
+	 * itself.
+	 */
+	inline void expandResponseFiles(std::string_view arg, std::pmr::vector<std::string_view> &args,
+			std::pmr::vector<std::shared_ptr<void>> &retained) {
+		if (arg.size() < 2 || arg[0] != '@') {
+			args.push_back(arg);
+			return;
+		}
+
+		std::pmr::vector<std::pair<std::uintmax_t, std::uintmax_t>> chain(args.get_allocator());
+		detail::expandResponseFile(arg, args, retained, chain);
+	}
+}
+
+#endif  // _TARG_RESPONSE_HPP_
@@ -0,0 +1,319 @@
+/*
+ * Parsers whose option names are declared at compile time
+ */
+#ifndef _TARG_SCHEMA_HPP_
+#define _TARG_SCHEMA_HPP_
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "targ.hpp"
+
+namespace targ {
+	/*
+	 * A string literal which can be used as a template argument
+	 */
+	template <std::size_t N>
+	struct fixed_string {
+		char data[N]{};
+
+		constexpr fixed_string(const char (&str)[N]) {
+			std::copy_n(str, N, data);
+		}
+
+		constexpr std::string_view view() const { return std::string_view(data, N - 1); }
+	};
+
+	/*
+	 * Describes the names of one option in a schema.
+	 *
+	 * S	The short option name, or '\0' if the option has none
+	 * L	The long option name, or "" if the option has none
+	 */
+	template <char S, fixed_string L = "">
+	struct opt {
+		static constexpr char shortName = S;
+		static constexpr std::string_view longName = L.view();
+	};
+
+	namespace detail {
+		/*
+		 * Map a name hash into a table of 2^bits slots.
+		 */
+		constexpr std::size_t schemaSlot(std::size_t hash, std::size_t seed, unsigned bits) {
+			return ((hash ^ seed) * 0x9E3779B97F4A7C15ull) >> (64 - bits);
+		}
+
+		template <std::size_t N>
+		constexpr bool hasDuplicateNames(const std::array<char, N> &shortNames,
+				const std::array<std::string_view, N> &longNames) {
+			std::array<bool, 256> seen{};
+			for (char c : shortNames) {
+				if (c == '\0') continue;
+				if (seen[static_cast<unsigned char>(c)]) return true;
+				seen[static_cast<unsigned char>(c)] = true;
+			}
+
+			// Sorted, any duplicates are next to each other
+			std::array<std::string_view, N> sorted = longNames;
+			std::sort(sorted.begin(), sorted.end());
+
+			for (std::size_t i = 1; i < N; ++i) {
+				if (!sorted[i].empty() && sorted[i] == sorted[i - 1]) return true;
+			}
+
+			return false;
+		}
+
+		/*
+		 * A perfect hash of up to N names, built by hash and displace: names
+		 * are grouped into buckets by their hash, and each bucket has its own
+		 * seed, chosen so that its names land in slots no other name uses. The
+		 * table has at least twice as many slots as names, so seeds are found
+		 * after a few tries and the search stays cheap enough to run at compile
+		 * time for schemas of thousands of names.
+		 */
+		template <std::size_t N>
+		struct PerfectHash {
+			// log2 of the number of slots, and of the number of buckets
+			static constexpr unsigned bits = std::bit_width(std::max<std::size_t>(N, 1) * 2 - 1);
+			static constexpr unsigned bucketBits = bits > 2 ? bits - 2 : 0;
+
+			std::array<std::uint32_t, std::size_t(1) << bucketBits> seeds{};
+			bool found = false;
+
+			static constexpr std::size_t bucket(std::size_t hash) {
+				if constexpr (bucketBits == 0) return 0;
+				else return (hash * 0xC2B2AE3D27D4EB4Full) >> (64 - bucketBits);
+			}
+
+			/*
+			 * Get the slot of a name
+			 *
+			 * hash		The name's hash, from hashName
+			 */
+			constexpr std::size_t slot(std::size_t hash) const {
+				return schemaSlot(hash, seeds[bucket(hash)], bits);
+			}
+		};
+
+		/*
+		 * Find a perfect hash of a set of names. Empty names are left out.
+		 *
+		 * names	The names
+		 * Returns the hash, whose found member is false if two names have the
+		 * same hash.
+		 */
+		template <std::size_t N>
+		constexpr PerfectHash<N> findPerfectHash(const std::array<std::string_view, N> &names) {
+			typedef PerfectHash<N> Hash;
+			constexpr std::size_t bucketCount = std::size_t(1) << Hash::bucketBits;
+
+			Hash result;
+			std::array<std::size_t, N> hashes{};
+			std::array<std::size_t, bucketCount + 1> starts{};
+
+			for (std::size_t i = 0; i < N; ++i) {
+				hashes[i] = hashName(names[i]);
+				if (!names[i].empty()) ++starts[Hash::bucket(hashes[i]) + 1];
+			}
+
+			// Group the names by bucket
+			for (std::size_t b = 0; b < bucketCount; ++b) starts[b + 1] += starts[b];
+
+			std::array<std::size_t, N> members{};
+			std::array<std::size_t, bucketCount> filled{};
+			for (std::size_t i = 0; i < N; ++i) {
+				if (names[i].empty()) continue;
+
+				std::size_t b = Hash::bucket(hashes[i]);
+				members[starts[b] + filled[b]++] = hashes[i];
+			}
+
+			// Place the largest buckets first, while the table is emptiest
+			std::array<std::size_t, bucketCount> order{};
+			for (std::size_t b = 0; b < bucketCount; ++b) order[b] = b;
+			std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return filled[a] > filled[b]; });
+
+			std::array<bool, std::size_t(1) << Hash::bits> used{};
+
+			for (std::size_t b : order) {
+				std::size_t first = starts[b];
+				std::size_t last = starts[b] + filled[b];
+
+				for (std::size_t i = first; i < last; ++i) {
+					for (std::size_t j = i + 1; j < last; ++j) {
+						if (members[i] == members[j]) return result;
+					}
+				}
+
+				for (std::uint32_t seed = 0; ; ++seed) {
+					std::size_t placed = first;
+
+					for (; placed < last; ++placed) {
+						std::size_t slot = schemaSlot(members[placed], seed, Hash::bits);
+						if (used[slot]) break;
+						used[slot] = true;
+					}
+
+					if (placed == last) {
+						result.seeds[b] = seed;
+						break;
+					}
+
+					// Take this bucket's names out again and try the next seed
+					for (std::size_t i = first; i < placed; ++i) used[schemaSlot(members[i], seed, Hash::bits)] = false;
+				}
+			}
+
+			result.found = true;
+			return result;
+		}
+	}
+
+	/*
+	 * The option names of a parser, known at compile time.
+	 *
+	 * Long names are looked up through a perfect hash generated at compile
+	 * time, and short names through a direct table. Each lookup is a single
+	 * probe and one comparison. Declaring the same name twice is a compile
+	 * error.
+	 *
+	 * Opts		The options in the schema, as opt types
+	 */
+	template <typename... Opts>
+	class Schema {
+	public:
+		static constexpr std::size_t size = sizeof...(Opts);
+
+		static_assert(size < 0xFFFF, "Schema contains too many options");
+
+		static constexpr std::array<char, size> shortNames{Opts::shortName...};
+		static constexpr std::array<std::string_view, size> longNames{Opts::longName...};
+
+		static_assert(!detail::hasDuplicateNames(shortNames, longNames), "Schema contains duplicate option names");
+
+		// The total length of the long names
+		static constexpr std::size_t nameBytes = (std::size_t(0) + ... + Opts::longName.size());
+
+	private:
+		static constexpr detail::PerfectHash<size> hash = detail::findPerfectHash(longNames);
+		static_assert(hash.found, "Could not find a perfect hash for the long option names");
+
+		// Slot tables hold an index into the schema, or size for empty slots
+		static constexpr auto shortTable = [] {
+			std::array<std::uint16_t, 256> table{};
+			table.fill(size);
+			for (std::size_t i = 0; i < size; ++i) {
+				if (shortNames[i] != '\0') table[static_cast<unsigned char>(shortNames[i])] = i;
+			}
+			return table;
+		}();
+
+		static constexpr auto longTable = [] {
+			std::array<std::uint16_t, std::size_t(1) << hash.bits> table{};
+			table.fill(size);
+			for (std::size_t i = 0; i < size; ++i) {
+				if (!longNames[i].empty()) table[hash.slot(detail::hashName(longNames[i]))] = i;
+			}
+			return table;
+		}();
+
+	public:
+		/*
+		 * Find the index of a short name
+		 *
+		 * c		The short name
+		 * Returns the index of the option in the schema, or size if there is
+		 * no such option.
+		 */
+		static constexpr std::size_t findShort(char c) {
+			return shortTable[static_cast<unsigned char>(c)];
+		}
+
+		/*
+		 * Find the index of a long name
+		 *
+		 * name		The long name
+		 * Returns the index of the option in the schema, or size if there is
+		 * no such option.
+		 */
+		static constexpr std::size_t findLong(std::string_view name) {
+			std::size_t i = longTable[hash.slot(detail::hashName(name))];
+			return (i != size && longNames[i] == name) ? i : size;
+		}
+	};
+
+	/*
+	 * A parser whose option names are declared by a schema.
+	 *
+	 * Options are declared as members in the same way as for any other parser,
+	 * and each must match an entry in the schema. The parser's argument table
+	 * is allocated once, sized for the whole schema, rather than grown as
+	 * options are registered; registering an option then stores it in a fixed
+	 * slot table, and targ::parse looks options up through the schema's
+	 * perfect hash without allocating. Help strings are still copied into the
+	 * parser's memory resource, so for no heap allocation at all, construct
+	 * the parser with a std::pmr::monotonic_buffer_resource over a buffer.
+	 *
+	 * Base		The parser to extend, e.g. UnixParser
+	 * Opts		The options in the schema, as opt types
+	 */
+	template <typename Base, typename... Opts>
+	class SchemaParser : public Base {
+	public:
+		using schema = Schema<Opts...>;
+
+		SchemaParser() {
+			this->reserveArguments(schema::size, schema::nameBytes);
+		}
+
+		explicit SchemaParser(std::pmr::memory_resource *resource) : Base(resource) {
+			this->reserveArguments(schema::size, schema::nameBytes);
+		}
+
+	protected:
+		static std::string optionName(char shortName, std::string_view longName) {
+			return longName.empty() ? std::string(1, shortName) : std::string(longName);
+		}
+
+		// One slot per schema entry, plus a null slot for failed lookups
+		std::array<detail::ArgRef, schema::size + 1> slots{};
+
+		virtual void addOption(AbstractArgument *arg, char shortName, std::string_view longName) {
+			std::size_t i = shortName != '\0' ? schema::findShort(shortName) : schema::findLong(longName);
+
+			if (i == schema::size || schema::shortNames[i] != shortName || schema::longNames[i] != longName) {
+				throw std::invalid_argument("Option " + optionName(shortName, longName) + " is not in the schema");
+			} else if (slots[i]) {
+				throw std::invalid_argument("Duplicate option " + optionName(shortName, longName));
+			}
+
+			slots[i] = this->refOf(arg);
+		}
+
+	public:
+		AbstractArgument *findShortOption(char c) const {
+			return this->deref(slots[schema::findShort(c)]);
+		}
+
+		AbstractArgument *findLongOption(std::string_view name) const {
+			return this->deref(slots[schema::findLong(name)]);
+		}
+
+		std::string_view suggestOption(std::string_view name) const {
+			return detail::closestName(name, [](auto f) {
+				for (std::string_view longName : schema::longNames) {
+					if (!longName.empty()) f(longName);
+				}
+			});
+		}
+	};
+}
+
+#endif  // _TARG_SCHEMA_HPP_
@@ -0,0 +1,199 @@
+/*
+ * Subcommands, each with its own parser
+ */
+#ifndef _TARG_SUBCOMMAND_HPP_
+#define _TARG_SUBCOMMAND_HPP_
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "schema.hpp"
+#include "targ.hpp"
+
+namespace targ {
+	/*
+	 * Describes one subcommand.
+	 *
+	 * Name		The name which selects the subcommand
+	 * P		The parser for the subcommand's arguments
+	 */
+	template <fixed_string Name, typename P>
+	struct command {
+		static_assert(std::derived_from<P, AbstractParser>, "A command's parser must be a subclass of AbstractParser");
+
+		static constexpr std::string_view name = Name.view();
+		typedef P parser;
+	};
+
+	/*
+	 * A positional argument which selects a subcommand. The subcommands are
+	 * fixed at compile time, and only the selected subcommand's parser is
+	 * constructed; it then parses every argument after the subcommand's name.
+	 * Options before the name belong to the enclosing parser. Names are looked
+	 * up through a perfect hash generated at compile time.
+	 *
+	 * This takes all the remaining arguments, so it must be the last
+	 * positional argument declared.
+	 *
+	 * For example:
+	 *	struct Git : targ::UnixParser {
+	 *		targ::Switch verbose{this, 'v', "verbose", "Show verbose output"};
+	 *		targ::Subcommand<targ::command<"clone", CloneParser>,
+	 *			targ::command<"commit", CommitParser>> command{this, "The command to run"};
+	 *	};
+	 *
+	 * Commands		The subcommands, as command types
+	 */
+	template <typename... Commands>
+	class Subcommand : public AbstractArgument {
+	public:
+		static constexpr std::size_t size = sizeof...(Commands);
+
+		static constexpr std::array<std::string_view, size> names{Commands::name...};
+
+	private:
+		static_assert(size > 0, "Subcommand needs at least one command");
+		static_assert(size < 0xFFFF, "Subcommand has too many commands");
+		static_assert(!detail::hasDuplicateNames(std::array<char, size>{}, names), "Subcommand has duplicate names");
+
+		static constexpr detail::PerfectHash<size> hash = detail::findPerfectHash(names);
+		static_assert(hash.found, "Could not find a perfect hash for the command names");
+
+		// Slot table of indices into names, or size for empty slots
+		static constexpr auto table = [] {
+			std::array<std::uint16_t, std::size_t(1) << hash.bits> table{};
+			table.fill(size);
+			for (std::size_t i = 0; i < size; ++i) {
+				table[hash.slot(detail::hashName(names[i]))] = i;
+			}
+			return table;
+		}();
+
+		// Whether exactly one command has the parser type P
+		template <typename P>
+		static constexpr bool isUniqueParser = (std::size_t(0) + ... + std::is_same_v<P, typename Commands::parser>) == 1;
+
+		// The selected command's parser, constructed only once it's selected
+		std::variant<std::monostate, typename Commands::parser...> selected;
+
+		/*
+		 * Construct and run the parser of one command
+		 */
+		template <std::size_t I>
+		static void run(Subcommand &self, std::span<const std::string_view> argv) {
+			typedef std::variant_alternative_t<I + 1, decltype(selected)> P;
+			std::pmr::memory_resource *resource = self.getParser()->resource;
+
+			if constexpr (std::constructible_from<P, std::pmr::memory_resource *>) {
+				parse(self.selected.template emplace<I + 1>(resource), argv);
+			} else {
+				parse(self.selected.template emplace<I + 1>(), argv);
+			}
+		}
+
+		// One entry point per command, indexed like names
+		static constexpr auto runners = []<std::size_t... I>(std::index_sequence<I...>) {
+			return std::array<void (*)(Subcommand &, std::span<const std::string_view>), size>{&run<I>...};
+		}(std::index_sequence_for<Commands...>());
+
+	public:
+		/*
+		 * Construct a new subcommand argument
+		 *
+		 * parser	The parser to add the argument to
+		 * help		A help string
+		 */
+		Subcommand(AbstractParser *parser, std::string_view help)
+				: AbstractArgument(parser, ArgKind::positional, help, Arity::rest) {
+			addToParser(parser, true);
+		}
+
+		/*
+		 * Find a command by name
+		 *
+		 * name		The name
+		 * Returns the index of the command, or size if there is none.
+		 */
+		static constexpr std::size_t find(std::string_view name) {
+			std::size_t i = table[hash.slot(detail::hashName(name))];
+			return (i != size && names[i] == name) ? i : size;
+		}
+
+		/*
+		 * Get the index of the selected command, or size if none was given
+		 */
+		std::size_t index() const {
+			return selected.index() == 0 ? size : selected.index() - 1;
+		}
+
+		/*
+		 * Get the parser of the selected command
+		 *
+		 * P	The command's parser type. Commands which share a parser type
+		 * 		must be told apart by index instead.
+		 * Returns the parser, or nullptr if a different command was selected.
+		 */
+		template <typename P>
+		P *get() {
+			static_assert(isUniqueParser<P>, "The parser type must belong to exactly one command; use get<I>");
+			return std::get_if<P>(&selected);
+		}
+
+		template <typename P>
+		const P *get() const {
+			static_assert(isUniqueParser<P>, "The parser type must belong to exactly one command; use get<I>");
+			return std::get_if<P>(&selected);
+		}
+
+		/*
+		 * Get the parser of the selected command by index
+		 *
+		 * I	The command's index, in the order of Commands
+		 * Returns the parser, or nullptr if a different command was selected.
+		 */
+		template <std::size_t I>
+		auto *get() {
+			static_assert(I < size, "Command index out of range");
+			return std::get_if<I + 1>(&selected);
+		}
+
+		template <std::size_t I>
+		const auto *get() const {
+			static_assert(I < size, "Command index out of range");
+			return std::get_if<I + 1>(&selected);
+		}
+
+		virtual std::string displayName() const {
+			return "Command";
+		}
+
+		virtual int parseArg(std::span<const std::string_view> argv) {
+			std::size_t i = find(argv[0]);
+
+			if (i == size) {
+				std::string msg = "Unknown command " + std::string(argv[0]);
+				std::string_view best = detail::closestName(argv[0], [](auto f) {
+					for (std::string_view name : names) f(name);
+				});
+
+				if (!best.empty()) msg += ", did you mean " + std::string(best) + "?";
+				throw ParsingError(msg);
+			}
+
+			runners[i](*this, argv.subspan(1));
+			return argv.size();
+		}
+	};
+}
+
+#endif  // _TARG_SUBCOMMAND_HPP_
@@ -1,269 +1,2559 @@
 #ifndef _TARG_HPP_
 #define _TARG_HPP_
 
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <exception>
+#include <limits>
+#include <list>
+#include <memory>
+#include <memory_resource>
 #include <optional>
+#include <ranges>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TARG_X86_SIMD
+#include <immintrin.h>
+#endif
+
 namespace targ {
 	class AbstractArgument;
 
-	struct any_tag {};
-	struct option_tag : public any_tag {};
-	struct positional_tag : public any_tag {};
+	class AbstractParser;
+
+	namespace detail {
+		/*
+		 * A range of command line arguments which can be parsed from views. Each
+		 * element converts to std::string_view and outlives the iteration: it
+		 * is a string_view or a C string, which refer to storage outside the
+		 * range, or an lvalue in a range which isn't a temporary, or which
+		 * doesn't own its elements. Those ranges must be forward ranges, since
+		 * an input range such as std::views::istream may reuse one element's
+		 * storage for the next.
+		 */
+		template <typename R>
+		concept token_range = std::ranges::input_range<R>
+			&& std::convertible_to<std::ranges::range_reference_t<R>, std::string_view>
+			&& (std::same_as<std::remove_cvref_t<std::ranges::range_reference_t<R>>, std::string_view>
+				|| std::is_pointer_v<std::remove_cvref_t<std::ranges::range_reference_t<R>>>
+				|| (std::ranges::forward_range<R> && std::is_lvalue_reference_v<std::ranges::range_reference_t<R>>
+					&& (std::ranges::borrowed_range<R> || std::is_lvalue_reference_v<R>)));
+	}
+
+	template <typename T>
+	void parse(T &parser, int argc, char **argv) requires std::derived_from<T, AbstractParser>;
+
+	template <typename T, detail::token_range R>
+	void parse(T &parser, R &&tokens) requires std::derived_from<T, AbstractParser>;
+
+	/*
+	 * The kinds of argument. Each argument's kind is fixed by its class, so
+	 * parsers can filter arguments with a single comparison.
+	 */
+	enum class ArgKind : unsigned char {
+		option,
+		positional
+	};
+
+	/*
+	 * How many values an argument takes. targ::parse works out which command
+	 * line arguments are an argument's values from this, and passes it
+	 * exactly those.
+	 */
+	enum class Arity : unsigned char {
+		none,		// a switch
+		one,		// a value attached to the option, or the next argument
+		optional,	// only a value attached to the option, as with getopt's
+					// "::"
+		many,		// a value attached to the option, or the following
+					// arguments up to the next which looks like an option
+		rest		// every remaining argument
+	};
+
+	namespace detail {
+		struct LexedToken;
+
+		template <typename T>
+		void handleUnknown(T &parser, std::string_view arg, const LexedToken &record);
+
+		template <typename T>
+		class Dispatcher;
+
+		template <typename T>
+		std::size_t lexTokens(T &parser, std::span<const std::string_view> args, std::pmr::vector<LexedToken> &lexed,
+			std::size_t start);
+
+		template <typename T>
+		std::size_t parseShortOption(T &parser, Dispatcher<T> &dispatcher, std::span<const std::string_view> args,
+			std::span<const LexedToken> lexed, std::size_t i);
+
+		template <typename T>
+		std::size_t parseLongOption(T &parser, Dispatcher<T> &dispatcher, std::span<const std::string_view> args,
+			std::span<const LexedToken> lexed, std::size_t i);
+
+		// Vectors with any allocator, including std::pmr::vector
+		template <typename T>
+		struct is_vector : std::false_type {};
+
+		template <typename T, typename A>
+		struct is_vector<std::vector<T, A>> : std::true_type {};
+
+		template <typename T>
+		struct is_optional : std::false_type {};
+
+		template <typename T>
+		struct is_optional<std::optional<T>> : std::true_type {};
+
+		/*
+		 * FNV-1a hash of a string
+		 */
+		constexpr std::size_t hashName(std::string_view str) {
+			std::size_t hash = 14695981039346656037ull;
+
+			for (char c : str) {
+				hash ^= static_cast<unsigned char>(c);
+				hash *= 1099511628211ull;
+			}
+
+			return hash;
+		}
+
+		/*
+		 * Find the multiplier for a unit suffix on a number: k, M and G for
+		 * powers of 1000, and s and ms for seconds.
+		 *
+		 * suffix	The suffix
+		 * mult		Set to the multiplier
+		 * div		Set to the divisor
+		 * Returns false if the suffix isn't a known unit.
+		 */
+		constexpr bool unitScale(std::string_view suffix, unsigned long long &mult, unsigned long long &div) {
+			mult = 1;
+			div = 1;
+
+			if (suffix.empty() || suffix == "s") {
+			} else if (suffix == "k") {
+				mult = 1000ull;
+			} else if (suffix == "M") {
+				mult = 1000000ull;
+			} else if (suffix == "G") {
+				mult = 1000000000ull;
+			} else if (suffix == "ms") {
+				div = 1000ull;
+			} else {
+				return false;
+			}
+
+			return true;
+		}
+
+		/*
+		 * Parse a number with std::from_chars, so no locale is used and nothing
+		 * is allocated.
+		 *
+		 * Integers may have a 0x, 0o or 0b prefix after their sign to select
+		 * base 16, 8 or 2. Any number may be followed by a unit suffix (see
+		 * unitScale); integers must still be whole after scaling.
+		 *
+		 * str		The string to parse
+		 * out		Set to the parsed number
+		 * Returns nullptr on success, or a description of the error.
+		 */
+		template <typename T>
+		const char *parseNumber(std::string_view str, T &out) requires std::is_arithmetic_v<T> {
+			const char *first = str.data();
+			const char *last = str.data() + str.size();
+
+			bool negative = false;
+			if (first != last && (*first == '-' || *first == '+')) {
+				negative = *first == '-';
+				++first;
+			}
+
+			// from_chars would take a second sign for floating point
+			if (first != last && (*first == '-' || *first == '+')) return "expects a number";
+
+			unsigned long long mult, div;
+
+			if constexpr (std::is_floating_point_v<T>) {
+				T magnitude;
+				auto [ptr, ec] = std::from_chars(first, last, magnitude, std::chars_format::general);
+
+				if (ec == std::errc::result_out_of_range) return "is out of range";
+				if (ec != std::errc() || ptr == first) return "expects a number";
+				if (!unitScale(std::string_view(ptr, last - ptr), mult, div)) return "has an unknown unit";
+
+				T result = magnitude * static_cast<T>(mult) / static_cast<T>(div);
+				if (std::isinf(result) && !std::isinf(magnitude)) return "is out of range";
+
+				out = negative ? -result : result;
+			} else {
+				int base = 10;
+				if (last - first >= 2 && first[0] == '0') {
+					switch (first[1]) {
+						case 'x': case 'X': base = 16; break;
+						case 'o': case 'O': base = 8; break;
+						case 'b': case 'B': base = 2; break;
+					}
+
+					if (base != 10) first += 2;
+				}
+
+				unsigned long long magnitude;
+				auto [ptr, ec] = std::from_chars(first, last, magnitude, base);
+
+				if (ec == std::errc::result_out_of_range) return "is out of range";
+				if (ec != std::errc() || ptr == first) return "expects a number";
+				if (!unitScale(std::string_view(ptr, last - ptr), mult, div)) return "has an unknown unit";
+
+				if (magnitude > std::numeric_limits<unsigned long long>::max() / mult) return "is out of range";
+				magnitude *= mult;
+				if (magnitude % div != 0) return "expects a whole number";
+				magnitude /= div;
+
+				if (negative) {
+					if constexpr (std::is_signed_v<T>) {
+						constexpr unsigned long long minMagnitude =
+							static_cast<unsigned long long>(std::numeric_limits<T>::max()) + 1;
+
+						if (magnitude > minMagnitude) return "is out of range";
+						out = magnitude == 0 ? T(0) : static_cast<T>(-static_cast<T>(magnitude - 1) - 1);
+					} else {
+						if (magnitude != 0) return "is out of range";
+						out = 0;
+					}
+				} else {
+					if (magnitude > static_cast<unsigned long long>(std::numeric_limits<T>::max())) return "is out of range";
+					out = static_cast<T>(magnitude);
+				}
+			}
+
+			return nullptr;
+		}
+
+		/*
+		 * Levenshtein distance between two strings, giving up once it is known
+		 * to be more than a bound.
+		 *
+		 * a, b		The strings to compare
+		 * bound	The largest distance of interest
+		 * Returns the distance, or bound + 1 if it is more than bound.
+		 */
+		inline std::size_t editDistance(std::string_view a, std::string_view b, std::size_t bound) {
+			if ((a.size() > b.size() ? a.size() - b.size() : b.size() - a.size()) > bound) return bound + 1;
+
+			std::vector<std::size_t> row(b.size() + 1);
+			for (std::size_t j = 0; j <= b.size(); ++j) row[j] = j;
+
+			for (std::size_t i = 1; i <= a.size(); ++i) {
+				std::size_t diagonal = row[0];
+				std::size_t rowMin = row[0] = i;
+
+				for (std::size_t j = 1; j <= b.size(); ++j) {
+					std::size_t above = row[j];
+					row[j] = std::min({above + 1, row[j - 1] + 1, diagonal + (a[i - 1] != b[j - 1])});
+					diagonal = above;
+					rowMin = std::min(rowMin, row[j]);
+				}
+
+				if (rowMin > bound) return bound + 1;
+			}
+
+			return std::min(row[b.size()], bound + 1);
+		}
+
+		/*
+		 * Find the name closest to a misspelt one, out of a set of names. Only
+		 * names within a small edit distance are considered.
+		 *
+		 * name			The misspelt name
+		 * forEachName	Calls its argument with every name
+		 * Returns the closest name, or an empty string if no name is close.
+		 */
+		template <typename F>
+		std::string_view closestName(std::string_view name, F forEachName) {
+			std::size_t bound = std::max<std::size_t>(1, name.size() / 3);
+			std::string_view best;
+
+			forEachName([&](std::string_view candidate) {
+				std::size_t distance = editDistance(name, candidate, bound);
+
+				if (distance <= bound) {
+					best = candidate;
+					bound = distance - (distance > 0);
+				}
+			});
+
+			return best;
+		}
+
+		/*
+		 * Byte matching primitives for option names. The SSE2 and AVX2 versions
+		 * compare 16 or 32 bytes at a time and finish with the scalar version,
+		 * so every version gives the same results. The best version the CPU
+		 * supports is chosen the first time nameMatcher is called.
+		 */
+		struct NameMatcher {
+			// Index of the first c in s[0, n), or n if there is none
+			std::size_t (*find)(const char *s, std::size_t n, char c);
+			// Whether a[0, n) and b[0, n) are the same
+			bool (*equal)(const char *a, const char *b, std::size_t n);
+		};
+
+		inline std::size_t findScalar(const char *s, std::size_t n, char c) {
+			const void *p = n ? std::memchr(s, c, n) : nullptr;
+			return p ? static_cast<const char *>(p) - s : n;
+		}
+
+		inline bool equalScalar(const char *a, const char *b, std::size_t n) {
+			return n == 0 || std::memcmp(a, b, n) == 0;
+		}
+
+#ifdef TARG_X86_SIMD
+		__attribute__((target("sse2")))
+		inline std::size_t findSSE2(const char *s, std::size_t n, char c) {
+			const __m128i needle = _mm_set1_epi8(c);
+			std::size_t i = 0;
+
+			for (; i + 16 <= n; i += 16) {
+				__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+				unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+				if (mask) return i + __builtin_ctz(mask);
+			}
+
+			return i + findScalar(s + i, n - i, c);
+		}
+
+		__attribute__((target("sse2")))
+		inline bool equalSSE2(const char *a, const char *b, std::size_t n) {
+			std::size_t i = 0;
+
+			for (; i + 16 <= n; i += 16) {
+				__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+				__m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+				if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xFFFF) return false;
+			}
+
+			return equalScalar(a + i, b + i, n - i);
+		}
+
+		__attribute__((target("avx2")))
+		inline std::size_t findAVX2(const char *s, std::size_t n, char c) {
+			const __m256i needle = _mm256_set1_epi8(c);
+			std::size_t i = 0;
+
+			for (; i + 32 <= n; i += 32) {
+				__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i));
+				unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle));
+				if (mask) return i + __builtin_ctz(mask);
+			}
+
+			return i + findSSE2(s + i, n - i, c);
+		}
+
+		__attribute__((target("avx2")))
+		inline bool equalAVX2(const char *a, const char *b, std::size_t n) {
+			std::size_t i = 0;
+
+			for (; i + 32 <= n; i += 32) {
+				__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+				__m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+				if (static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y))) != 0xFFFFFFFFu) return false;
+			}
+
+			return equalSSE2(a + i, b + i, n - i);
+		}
+#endif
+
+		inline const NameMatcher &nameMatcher() {
+			static const NameMatcher matcher = [] {
+#ifdef TARG_X86_SIMD
+				if (__builtin_cpu_supports("avx2")) return NameMatcher{findAVX2, equalAVX2};
+				if (__builtin_cpu_supports("sse2")) return NameMatcher{findSSE2, equalSSE2};
+#endif
+				return NameMatcher{findScalar, equalScalar};
+			}();
+
+			return matcher;
+		}
+
+		inline bool namesEqual(std::string_view a, std::string_view b) {
+			return a.size() == b.size() && nameMatcher().equal(a.data(), b.data(), a.size());
+		}
+
+		/*
+		 * A long option with its prefix removed, split at the first value
+		 * separator. Both parts are views of the original string.
+		 */
+		struct LongToken {
+			std::string_view name;
+			std::string_view value;
+			bool hasValue = false;
+		};
+
+		inline LongToken splitLongToken(std::string_view str, std::string_view separators = "=") {
+			std::size_t i = str.size();
+			for (char c : separators) {
+				i = nameMatcher().find(str.data(), i, c);
+			}
+
+			if (i == str.size()) return LongToken{str, {}, false};
+
+			return LongToken{str.substr(0, i), str.substr(i + 1), true};
+		}
+
+		/*
+		 * A reference to an argument, stored as its offset from the parser it
+		 * belongs to. Arguments are members of their parser, so the offset stays
+		 * the same when the parser is moved. 0 refers to no argument.
+		 */
+		typedef std::ptrdiff_t ArgRef;
+
+		/*
+		 * Metadata of a parser's arguments, indexed by argument id.
+		 *
+		 * Each field is kept in its own array, so matching names only touches
+		 * dense memory: short names are one byte per argument, and long names
+		 * are interned in a single buffer. Long names are indexed by a flat,
+		 * open addressing hash table of ids, kept at most half full so probe
+		 * sequences stay short. The table keeps its own copy of every name, so
+		 * it stays valid when the arguments it refers to are moved.
+		 */
+		class ArgumentTable {
+		private:
+			// Argument id + 1 for each long name, or 0 for an empty slot
+			std::pmr::vector<std::uint32_t> slots;
+			std::size_t longCount = 0;
+
+			void place(std::uint32_t id) {
+				std::size_t mask = slots.size() - 1;
+				std::size_t i = hashName(longName(id)) & mask;
+
+				while (slots[i]) i = (i + 1) & mask;
+				slots[i] = id + 1;
+			}
+
+			void grow() {
+				std::pmr::vector<std::uint32_t> old = std::move(slots);
+				slots.assign(old.empty() ? 16 : old.size() * 2, 0);
+
+				for (std::uint32_t slot : old) {
+					if (slot) place(slot - 1);
+				}
+			}
+
+		public:
+			std::pmr::vector<ArgRef> refs;
+			std::pmr::vector<ArgKind> kinds;
+			std::pmr::vector<char> shortNames;
+			std::pmr::vector<std::uint32_t> longOffsets;
+			std::pmr::vector<std::uint32_t> longLengths;
+			std::pmr::string longNames;
+
+			/*
+			 * Construct an empty table
+			 *
+			 * resource		The memory resource to allocate from
+			 */
+			explicit ArgumentTable(std::pmr::memory_resource *resource)
+				: slots(resource), refs(resource), kinds(resource), shortNames(resource), longOffsets(resource),
+				  longLengths(resource), longNames(resource) {}
+
+			std::size_t size() const { return refs.size(); }
+
+			/*
+			 * Reserve space for a number of arguments
+			 *
+			 * n			The number of arguments
+			 * nameBytes	The total length of their long names
+			 */
+			void reserve(std::size_t n, std::size_t nameBytes = 0) {
+				refs.reserve(n);
+				kinds.reserve(n);
+				shortNames.reserve(n);
+				longOffsets.reserve(n);
+				longLengths.reserve(n);
+				longNames.reserve(nameBytes);
+			}
+
+			/*
+			 * Add an argument to the table. Its long name isn't indexed until
+			 * indexLong is called.
+			 *
+			 * ref			The argument
+			 * kind			The kind of argument
+			 * shortName	The short name of the argument, or '\0'
+			 * longName		The long name of the argument, or an empty string
+			 * Returns the id of the argument.
+			 */
+			std::uint32_t add(ArgRef ref, ArgKind kind, char shortName, std::string_view longName) {
+				refs.push_back(ref);
+				kinds.push_back(kind);
+				shortNames.push_back(shortName);
+				longOffsets.push_back(static_cast<std::uint32_t>(longNames.size()));
+				longLengths.push_back(static_cast<std::uint32_t>(longName.size()));
+				longNames.append(longName);
+
+				return static_cast<std::uint32_t>(refs.size() - 1);
+			}
+
+			std::string_view longName(std::size_t id) const {
+				return std::string_view(longNames).substr(longOffsets[id], longLengths[id]);
+			}
+
+			/*
+			 * Add an argument's long name to the index
+			 *
+			 * id		The argument
+			 * Returns false if another argument has the same long name.
+			 */
+			bool indexLong(std::uint32_t id) {
+				if (findLong(longName(id)) != size()) return false;
+				if ((longCount + 1) * 2 > slots.size()) grow();
+
+				place(id);
+				++longCount;
+				return true;
+			}
+
+			/*
+			 * Look up a long name in the index
+			 *
+			 * name		The name to look up
+			 * Returns the id of the argument with that name, or size() if there
+			 * is none.
+			 */
+			std::size_t findLong(std::string_view name) const {
+				if (slots.empty()) return size();
+
+				std::size_t mask = slots.size() - 1;
+				for (std::size_t i = hashName(name) & mask; slots[i]; i = (i + 1) & mask) {
+					if (namesEqual(longName(slots[i] - 1), name)) return slots[i] - 1;
+				}
+
+				return size();
+			}
+
+			/*
+			 * Call a function with every indexed long name
+			 *
+			 * f		The function to call
+			 */
+			template <typename F>
+			void forEachLong(F f) const {
+				for (std::uint32_t slot : slots) {
+					if (slot) f(longName(slot - 1));
+				}
+			}
+		};
+
+		constexpr unsigned char foldCase(char c) {
+			return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : static_cast<unsigned char>(c);
+		}
+
+		/*
+		 * A radix trie over the long option names in an argument table, for
+		 * resolving abbreviated names. Edge labels are views of the table's
+		 * interned names, and each node knows the range of sorted names below
+		 * it, so a lookup also gives every name the token is a prefix of.
+		 * Names may be compared with ASCII letters folded to lower case.
+		 */
+		class NameTrie {
+		private:
+			struct Node {
+				std::uint32_t labelOffset = 0;
+				std::uint32_t labelLength = 0;
+				// Node indices; 0 (the root) means none
+				std::uint32_t firstChild = 0;
+				std::uint32_t nextSibling = 0;
+				// Argument id + 1 of the name ending here, or 0
+				std::uint32_t terminal = 0;
+				// Range of sorted names below this node
+				std::uint32_t first = 0;
+				std::uint32_t last = 0;
+			};
+
+			std::pmr::vector<Node> nodes;
+			// Ids of the named options, sorted by long name
+			std::pmr::vector<std::uint32_t> sorted;
+			bool folded = false;
+
+			bool equal(char a, char b) const {
+				return folded ? foldCase(a) == foldCase(b) : a == b;
+			}
+
+			bool startsWith(std::string_view str, std::string_view prefix) const {
+				return str.size() >= prefix.size()
+					&& std::ranges::equal(str.substr(0, prefix.size()), prefix, [this](char a, char b) { return equal(a, b); });
+			}
+
+			void buildNode(const ArgumentTable &table, std::uint32_t node, std::size_t first, std::size_t last,
+					std::size_t depth) {
+				std::string_view low = table.longName(sorted[first]);
+				std::string_view high = table.longName(sorted[last - 1]);
+				std::size_t common = std::ranges::mismatch(low, high, [this](char a, char b) { return equal(a, b); }).in1
+					- low.begin();
+
+				nodes[node].labelOffset = table.longOffsets[sorted[first]] + depth;
+				nodes[node].labelLength = common - depth;
+				nodes[node].first = first;
+				nodes[node].last = last;
+
+				std::size_t i = first;
+				if (low.size() == common) nodes[node].terminal = sorted[i++] + 1;
+
+				// Names are sorted, so each child is a run with the same next
+				// character
+				std::uint32_t previous = 0;
+				while (i < last) {
+					char c = table.longName(sorted[i])[common];
+					std::size_t end = i;
+					while (end < last && equal(table.longName(sorted[end])[common], c)) ++end;
+
+					std::uint32_t child = nodes.size();
+					nodes.emplace_back();
+					(previous ? nodes[previous].nextSibling : nodes[node].firstChild) = child;
+					previous = child;
+
+					buildNode(table, child, i, end, common);
+					i = end;
+				}
+			}
+
+		public:
+			/*
+			 * Result of a lookup
+			 */
+			struct Match {
+				// The id of the name matched exactly or by an unambiguous
+				// abbreviation, or npos
+				std::size_t id = std::string_view::npos;
+				// Ids of every name the token is a prefix of, sorted by name
+				std::span<const std::uint32_t> candidates;
+			};
+
+			explicit NameTrie(std::pmr::memory_resource *resource) : nodes(resource), sorted(resource) {}
+
+			/*
+			 * Rebuild the trie from the long names of every option in a table.
+			 * Lookups use the table's names, so it mustn't change afterwards
+			 * without rebuilding.
+			 *
+			 * table		The argument table
+			 * ignoreCase	Whether to fold ASCII letters to lower case. No two
+			 * 				names may then differ only in case.
+			 */
+			void build(const ArgumentTable &table, bool ignoreCase = false) {
+				nodes.clear();
+				sorted.clear();
+				folded = ignoreCase;
+
+				for (std::uint32_t id = 0; id < table.size(); ++id) {
+					if (table.kinds[id] == ArgKind::option && table.longLengths[id] != 0) sorted.push_back(id);
+				}
+
+				if (sorted.empty()) return;
+
+				std::ranges::sort(sorted, [&](std::uint32_t a, std::uint32_t b) {
+					return std::ranges::lexicographical_compare(table.longName(a), table.longName(b),
+						[this](char x, char y) { return folded ? foldCase(x) < foldCase(y) : x < y; });
+				});
+				nodes.emplace_back();
+				buildNode(table, 0, 0, sorted.size(), 0);
+			}
+
+			/*
+			 * Resolve a possibly abbreviated long name, in time proportional to
+			 * its length. An exact match wins over longer names it abbreviates.
+			 *
+			 * table	The table the trie was built from
+			 * name		The name, without its prefix
+			 */
+			Match find(const ArgumentTable &table, std::string_view name) const {
+				if (nodes.empty()) return Match{};
+
+				for (std::uint32_t n = 0; ; ) {
+					const Node &node = nodes[n];
+					std::string_view label = std::string_view(table.longNames).substr(node.labelOffset, node.labelLength);
+
+					if (name.size() <= label.size()) {
+						if (!startsWith(label, name)) return Match{};
+
+						std::span<const std::uint32_t> candidates(sorted.data() + node.first, node.last - node.first);
+						if (name.size() == label.size() && node.terminal) return Match{node.terminal - 1, candidates};
+						return Match{candidates.size() == 1 ? candidates[0] : std::string_view::npos, candidates};
+					}
+
+					if (!startsWith(name, label)) return Match{};
+					name.remove_prefix(label.size());
+
+					for (n = node.firstChild; n && !equal(table.longNames[nodes[n].labelOffset], name[0]);
+						n = nodes[n].nextSibling);
+					if (!n) return Match{};
+				}
+			}
+		};
+
+		/*
+		 * The environment variables which options are bound to, indexed by a
+		 * hash of their names so the environment can be matched against every
+		 * binding in one pass.
+		 */
+		class EnvironmentTable {
+		private:
+			// Binding index + 1 for each name, or 0 for an empty slot
+			std::pmr::vector<std::uint32_t> slots;
+			std::pmr::vector<std::uint32_t> offsets;
+			std::pmr::vector<std::uint32_t> lengths;
+			std::pmr::string names;
+
+			void place(std::uint32_t i) {
+				std::size_t mask = slots.size() - 1;
+				std::size_t j = hashName(name(i)) & mask;
+
+				while (slots[j]) j = (j + 1) & mask;
+				slots[j] = i + 1;
+			}
+
+		public:
+			// The argument each variable is bound to
+			std::pmr::vector<ArgRef> refs;
+
+			/*
+			 * Construct an empty table
+			 *
+			 * resource		The memory resource to allocate from
+			 */
+			explicit EnvironmentTable(std::pmr::memory_resource *resource)
+				: slots(resource), offsets(resource), lengths(resource), names(resource), refs(resource) {}
+
+			std::size_t size() const { return refs.size(); }
+
+			std::string_view name(std::size_t i) const {
+				return std::string_view(names).substr(offsets[i], lengths[i]);
+			}
+
+			/*
+			 * Bind a variable to an argument
+			 *
+			 * ref			The argument
+			 * variable		The name of the environment variable
+			 * Returns false if the variable is already bound.
+			 */
+			bool bind(ArgRef ref, std::string_view variable) {
+				if (find(variable) != size()) return false;
+
+				refs.push_back(ref);
+				offsets.push_back(static_cast<std::uint32_t>(names.size()));
+				lengths.push_back(static_cast<std::uint32_t>(variable.size()));
+				names.append(variable);
+
+				if (size() * 2 > slots.size()) {
+					slots.assign(slots.empty() ? 16 : slots.size() * 2, 0);
+					for (std::uint32_t i = 0; i < size(); ++i) place(i);
+				} else {
+					place(size() - 1);
+				}
+
+				return true;
+			}
+
+			/*
+			 * Look up a variable
+			 *
+			 * variable		The name of the environment variable
+			 * Returns the index of its binding, or size() if it isn't bound.
+			 */
+			std::size_t find(std::string_view variable) const {
+				if (slots.empty()) return size();
+
+				std::size_t mask = slots.size() - 1;
+				for (std::size_t j = hashName(variable) & mask; slots[j]; j = (j + 1) & mask) {
+					if (namesEqual(name(slots[j] - 1), variable)) return slots[j] - 1;
+				}
+
+				return size();
+			}
+		};
+
+#ifndef _WIN32
+		// The C library's environ. Declared here, it names the same object as
+		// <unistd.h> does, without adding a name to the global namespace.
+		extern "C" char **environ;
+#endif
+
+		/*
+		 * Get the process's environment, as "NAME=value" strings ending in a
+		 * null pointer
+		 */
+		inline char **environment() {
+#ifdef _WIN32
+			return _environ;
+#else
+			return detail::environ;
+#endif
+		}
+
+		/*
+		 * Parse a switch's value from an environment variable. 1, true, yes and
+		 * on are true; 0, false, no, off and the empty string are false. Case
+		 * is ignored.
+		 *
+		 * str		The string to parse
+		 * out		Set to the parsed value
+		 * Returns nullptr on success, or a description of the error.
+		 */
+		inline const char *parseFlag(std::string_view str, bool &out) {
+			auto is = [str](std::string_view word) {
+				return std::ranges::equal(str, word, [](char a, char b) {
+					return (a >= 'A' && a <= 'Z' ? a - 'A' + 'a' : a) == b;
+				});
+			};
+
+			if (str.empty() || is("0") || is("false") || is("no") || is("off")) {
+				out = false;
+			} else if (is("1") || is("true") || is("yes") || is("on")) {
+				out = true;
+			} else {
+				return "is not a boolean";
+			}
+
+			return nullptr;
+		}
+	}
+
+	/*
+	 * An exception thrown when parsing is invalid. This exception is used to
+	 * signal invalid user input.
+	 */
+	class ParsingError : public std::runtime_error {
+	public:
+		ParsingError(std::string msg) : std::runtime_error(msg) {}
+		const char *what() const throw() { return std::runtime_error::what(); }
+	};
+
+	/*
+	 * What targ::parse does with a command line argument which none of the
+	 * parser's arguments accepts.
+	 */
+	enum class UnknownPolicy {
+		error,		// throw ParsingError
+		collect,	// add it to AbstractParser::unknownArgs
+		ignore		// skip it
+	};
+
+	/*
+	 * The kinds of command line argument, by their prefix
+	 */
+	enum class TokenKind : unsigned char {
+		positional,
+		shortOption,
+		longOption,
+		negatedOption,	// turns a long option off, e.g. "+sb"
+		terminator		// ends option parsing, e.g. "--"
+	};
+
+	/*
+	 * A command line argument, classified by its prefix
+	 */
+	struct Token {
+		TokenKind kind;
+		// The option name without its prefix, or the whole argument
+		std::string_view name;
+	};
+
+	/*
+	 * The prefixes which mark a parser's options. Each argument is classified
+	 * once, before it is dispatched. The first character of the argument is
+	 * looked up in a table first, so most positional arguments are rejected
+	 * with a single load.
+	 */
+	class OptionStyle {
+	private:
+		// Whether each character starts one of the prefixes
+		std::array<bool, 256> leads{};
+
+	public:
+		std::string_view shortPrefix;
+		std::string_view longPrefix;
+		std::string_view terminator;
+		std::string_view negationPrefix;
+
+		/*
+		 * A style with no options
+		 */
+		constexpr OptionStyle() = default;
+
+		/*
+		 * Construct a style
+		 *
+		 * shortPrefix	The prefix of short options, or "" if there are none
+		 * longPrefix	The prefix of long options, or "" if there are none
+		 * terminator	An argument which ends option parsing, or ""
+		 * negationPrefix	The prefix which turns a long option off, or ""
+		 */
+		constexpr OptionStyle(std::string_view shortPrefix, std::string_view longPrefix,
+				std::string_view terminator = {}, std::string_view negationPrefix = {})
+				: shortPrefix(shortPrefix), longPrefix(longPrefix), terminator(terminator),
+				negationPrefix(negationPrefix) {
+			for (std::string_view prefix : {shortPrefix, longPrefix, terminator, negationPrefix}) {
+				if (!prefix.empty()) leads[static_cast<unsigned char>(prefix[0])] = true;
+			}
+		}
+
+		// -v, -abc, --verbose, and -- to end options
+		static constexpr OptionStyle posix() { return OptionStyle("-", "--", "--"); }
+
+		// /verbose, /I
+		static constexpr OptionStyle windows() { return OptionStyle({}, "/"); }
+
+		// -display, -geometry, and +sb to turn -sb off
+		static constexpr OptionStyle x11() { return OptionStyle({}, "-", {}, "+"); }
+
+		/*
+		 * Classify an argument by its prefix. A prefix on its own isn't an
+		 * option, so "-" is positional.
+		 *
+		 * str		The argument
+		 */
+		constexpr Token classify(std::string_view str) const {
+			if (str.empty() || !leads[static_cast<unsigned char>(str[0])]) return Token{TokenKind::positional, str};
+			if (!terminator.empty() && str == terminator) return Token{TokenKind::terminator, {}};
+
+			if (!negationPrefix.empty() && str.starts_with(negationPrefix) && str.length() > negationPrefix.length()) {
+				return Token{TokenKind::negatedOption, str.substr(negationPrefix.length())};
+			}
+
+			if (!longPrefix.empty() && str.starts_with(longPrefix) && str.length() > longPrefix.length()) {
+				return Token{TokenKind::longOption, str.substr(longPrefix.length())};
+			}
+
+			if (!shortPrefix.empty() && str.starts_with(shortPrefix) && str.length() > shortPrefix.length()) {
+				return Token{TokenKind::shortOption, str.substr(shortPrefix.length())};
+			}
+
+			return Token{TokenKind::positional, str};
+		}
+	};
+
+	namespace detail {
+		/*
+		 * A command line argument as classified by targ::parse's lexing pass,
+		 * before anything is dispatched. The name and value are stored as
+		 * offsets into the argument to keep the records small.
+		 */
+		struct LexedToken {
+			TokenKind kind = TokenKind::positional;
+			// Whether a value is attached after the name, as in --output=a.out;
+			// it runs from the end of the name plus one to the end
+			bool hasValue = false;
+			// Whether the name abbreviates more than one long option. This is
+			// only an error if the argument isn't taken as another's value.
+			bool ambiguous = false;
+			std::uint32_t nameOffset = 0;
+			std::uint32_t nameLength = 0;
+			// The option the name refers to, or nullptr. For a cluster of short
+			// options this is the first one.
+			AbstractArgument *option = nullptr;
+		};
+	}
+
+	/*
+	 * Abstract parser class. All parsers should inherit from this class.
+	 *
+	 * Specialized program argument parsers are created by subclassing this
+	 * class and adding member variables of an AbstractArgument type. Default
+	 * values should be set in the constructor.
+	 *
+	 * All of a parser's storage, and that of its arguments, is allocated from
+	 * its memory resource. Parsers which should be usable with a custom memory
+	 * resource must have a constructor which takes the resource and passes it
+	 * on to their base class.
+	 *
+	 * Arguments are registered by their offset from the parser rather than by
+	 * address, so parsers can be moved freely. Because of this, every argument
+	 * must be a member of the parser it is added to.
+	 *
+	 * Parsers can't be copied, since a copy of each container would allocate
+	 * from the default memory resource rather than the parser's, and can't be
+	 * assigned, since their memory resource and option style are fixed.
+	 */
+	class AbstractParser {
+		friend class AbstractArgument;
+
+		template <typename T>
+		friend void parse(T &parser, int argc, char **argv) requires std::derived_from<T, AbstractParser>;
+
+		template <typename T, detail::token_range R>
+		friend void parse(T &parser, R &&tokens) requires std::derived_from<T, AbstractParser>;
+
+		template <typename T>
+		friend void detail::handleUnknown(T &parser, std::string_view arg, const detail::LexedToken &record);
+
+		template <typename T>
+		friend class detail::Dispatcher;
+
+		template <typename T>
+		friend std::size_t detail::lexTokens(T &parser, std::span<const std::string_view> args,
+			std::pmr::vector<detail::LexedToken> &lexed, std::size_t start);
+
+		template <typename T>
+		friend std::size_t detail::parseShortOption(T &parser, detail::Dispatcher<T> &dispatcher,
+			std::span<const std::string_view> args, std::span<const detail::LexedToken> lexed, std::size_t i);
+
+		template <typename T>
+		friend std::size_t detail::parseLongOption(T &parser, detail::Dispatcher<T> &dispatcher,
+			std::span<const std::string_view> args, std::span<const detail::LexedToken> lexed, std::size_t i);
+
+	public:
+		std::pmr::memory_resource *const resource;
+
+	protected:
+		std::pmr::string prgmName;
+
+		// Every argument, in registration order. Long names are indexed here
+		// too.
+		detail::ArgumentTable args;
+
+		// Arguments indexed by short name
+		std::array<detail::ArgRef, 256> shortIndex{};
+
+		// Whether long options may be abbreviated to any unambiguous prefix,
+		// as with getopt_long, and the trie which resolves them. The trie is
+		// built when parsing starts.
+		bool allowAbbreviations = false;
+		detail::NameTrie longTrie;
+
+		// Positional arguments in the order they were declared, and the first
+		// which hasn't been filled. If the last positional argument is
+		// variadic it is never considered filled.
+		std::pmr::vector<detail::ArgRef> positionals;
+		std::size_t nextPositional = 0;
+		bool variadicPositional = false;
+
+		// One bit per argument, in registration order, set when the argument
+		// is found on the command line
+		std::pmr::vector<bool> present;
+
+		// How to handle unknown arguments, and those collected so far. The
+		// unknown rest of a cluster of short options isn't part of any
+		// argument, so it is stored here.
+		UnknownPolicy unknownPolicy = UnknownPolicy::error;
+		std::pmr::vector<std::string_view> unknown;
+		std::pmr::list<std::pmr::string> unknownClusters;
+
+		// Replaces each argument with the arguments it stands for before any
+		// is parsed, or nullptr to take the arguments as they are. Set it to
+		// targ::expandResponseFiles, from response.hpp, to replace @file with
+		// the arguments in the file, as gcc and MSVC do. What the new
+		// arguments are views of is kept in retained, for as long as the
+		// parser.
+		void (*expandArgument)(std::string_view arg, std::pmr::vector<std::string_view> &args,
+			std::pmr::vector<std::shared_ptr<void>> &retained) = nullptr;
+		std::pmr::vector<std::shared_ptr<void>> retained;
+
+		// Environment variables which options fall back to when they aren't
+		// on the command line. See Option::fromEnv.
+		detail::EnvironmentTable environment;
+
+	public:
+		// How options are told apart from other arguments
+		const OptionStyle optionStyle;
+
+		// Whether a short option prefix may be followed by several short
+		// options, or by a short option and its value. Parsers which support
+		// this hide it with true.
+		static constexpr bool clusterShortOptions = false;
+
+		// The characters which may separate a long option from its value, as
+		// the '=' in --output=a.out, or none. Parsers which support attached
+		// values hide this.
+		static constexpr std::string_view longValueSeparators = {};
+
+		// Whether an argument with the long option prefix which names no
+		// option is a positional argument instead of an unknown option, as an
+		// absolute path is for WindowsParser. Parsers hide this with true.
+		static constexpr bool unknownLongOptionsArePositional = false;
+
+		// Whether long option names match regardless of the case of ASCII
+		// letters, including abbreviations. Parsers whose lookups fold case
+		// hide this with true.
+		static constexpr bool caseInsensitive = false;
+
+		AbstractParser() : AbstractParser(OptionStyle()) {}
+
+		/*
+		 * Construct a parser which allocates from a memory resource
+		 *
+		 * resource		The memory resource to allocate from. It must outlive
+		 * 				the parser.
+		 */
+		explicit AbstractParser(std::pmr::memory_resource *resource) : AbstractParser(OptionStyle(), resource) {}
+
+		/*
+		 * Construct a parser with an option style
+		 *
+		 * style		The prefixes which mark options
+		 * resource		The memory resource to allocate from. It must outlive
+		 * 				the parser.
+		 */
+		explicit AbstractParser(const OptionStyle &style,
+				std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+			: resource(resource), prgmName(resource), args(resource), longTrie(resource), positionals(resource),
+			  present(resource), unknown(resource), unknownClusters(resource), retained(resource), environment(resource),
+			  optionStyle(style) {}
+
+		AbstractParser(const AbstractParser &) = delete;
+		AbstractParser &operator=(const AbstractParser &) = delete;
+
+		/*
+		 * Move a parser. Its storage is moved with it, so it stays allocated
+		 * from the same memory resource.
+		 */
+		AbstractParser(AbstractParser &&) = default;
+		AbstractParser &operator=(AbstractParser &&) = delete;
+
+		/*
+		 * Parse meta arguments; that is 'arguments' which inform the parser on
+		 * how to parse future arguments.
+		 *
+		 * arg		The meta-argument.
+		 * Returns true if the argument was consumed, false otherwise.
+		 */
+		virtual bool metaparser(std::string_view arg) { return false; }
+
+		/*
+		 * Discriminate arguments out of args. This is intended to be used in
+		 * conjunction with metaparser to selectively parse certain types of
+		 * arguments dependent on meta args.
+		 *
+		 * arg		A pointer to the argument which the parser wants to test.
+		 * Returns true if the parser should test for this argument, and false
+		 * if it shouldn't.
+		 */
+		virtual bool shouldTest(AbstractArgument *arg) { return true; }
+
+		/*
+		 * Find the option with a short name. Parsers which index their options
+		 * differently hide this; targ::parse calls it through the concrete
+		 * parser type.
+		 *
+		 * c		The short name
+		 * Returns the option, or nullptr if there is none.
+		 */
+		AbstractArgument *findShortOption(char c) const {
+			return deref(shortIndex[static_cast<unsigned char>(c)]);
+		}
+
+		/*
+		 * Find the option with a long name, without resolving abbreviations.
+		 * Parsers which hide findShortOption hide this too.
+		 *
+		 * name		The long name, without its prefix
+		 * Returns the option, or nullptr if there is none.
+		 */
+		AbstractArgument *findLongOption(std::string_view name) const {
+			std::size_t id = args.findLong(name);
+			return id == args.size() ? nullptr : deref(args.refs[id]);
+		}
+
+		/*
+		 * Find the long option name closest to a misspelt one. Parsers which
+		 * hide findLongOption hide this too.
+		 *
+		 * name		The misspelt name, without its prefix
+		 * Returns the closest name, or an empty string if no name is close.
+		 */
+		std::string_view suggestOption(std::string_view name) const {
+			return detail::closestName(name, [this](auto f) { args.forEachLong(f); });
+		}
+
+		/*
+		 * Test whether an argument was found on the command line
+		 *
+		 * arg		An argument of this parser
+		 */
+		bool isPresent(const AbstractArgument &arg) const;
+
+		/*
+		 * Get the arguments which weren't recognized, when the parser uses
+		 * UnknownPolicy::collect. These are views of argv, except that only
+		 * the unknown rest of a cluster of short options is collected, e.g.
+		 * -q from -aq when -a is known.
+		 */
+		std::span<const std::string_view> unknownArgs() const {
+			return unknown;
+		}
+
+		/*
+		 * Check every argument whose conversion is deferred, such as
+		 * LazyOption, so malformed arguments can be reported straight after
+		 * parsing rather than when they are first read.
+		 *
+		 * Throws ParsingError for the first malformed argument.
+		 */
+		void validateAll() const;
+
+	protected:
+		/*
+		 * Add an argument to the argument table, giving it its id. Called for
+		 * every argument before it is added to the parser's indexes.
+		 *
+		 * arg			The argument
+		 * shortName	The short name of the argument, or '\0'
+		 * longName		The long name of the argument, or an empty string
+		 */
+		void registerArgument(AbstractArgument *arg, char shortName, std::string_view longName);
+
+		/*
+		 * Record that an argument was found on the command line
+		 */
+		void markPresent(AbstractArgument *arg);
+
+		/*
+		 * Give each bound option which wasn't on the command line the value of
+		 * its environment variable. The environment is read once, and each
+		 * variable is looked up in the binding table, so the cost doesn't
+		 * depend on the number of bindings. Called by targ::parse.
+		 *
+		 * Throws ParsingError if a variable's value is malformed.
+		 */
+		void applyEnvironment();
+
+		/*
+		 * Get the id of an argument of this parser, its index in the argument
+		 * table
+		 */
+		std::size_t idOf(const AbstractArgument *arg) const;
+
+		/*
+		 * Reserve space for a number of arguments, for parsers which know how
+		 * many they have before registering them
+		 *
+		 * n			The number of arguments
+		 * nameBytes	The total length of their long names
+		 */
+		void reserveArguments(std::size_t n, std::size_t nameBytes = 0) {
+			args.reserve(n, nameBytes);
+			present.reserve(n);
+		}
+
+		/*
+		 * Get a reference to an argument of this parser
+		 */
+		detail::ArgRef refOf(const AbstractArgument *arg) const {
+			return reinterpret_cast<const char *>(arg) - reinterpret_cast<const char *>(this);
+		}
+
+		/*
+		 * Get the argument of this parser which a reference refers to, or
+		 * nullptr for the null reference.
+		 */
+		AbstractArgument *deref(detail::ArgRef ref) const {
+			if (!ref) return nullptr;
+			return reinterpret_cast<AbstractArgument *>(const_cast<char *>(reinterpret_cast<const char *>(this)) + ref);
+		}
+
+		/*
+		 * Register a named argument with this parser
+		 *
+		 * arg			The argument to register
+		 * shortName	The short name of the argument, or '\0' if it has none
+		 * longName		The long name of the argument, or an empty string if it
+		 * 				has none
+		 * Throws std::invalid_argument if either name is already in use.
+		 */
+		virtual void addOption(AbstractArgument *arg, char shortName, std::string_view longName);
+
+		/*
+		 * Resolve an abbreviated long option name through the trie
+		 *
+		 * name			The name, without its prefix
+		 * ambiguous	Set to whether more than one option starts with name
+		 * Returns the option, or nullptr if no option or more than one starts
+		 * with name.
+		 */
+		AbstractArgument *findAbbreviation(std::string_view name, bool &ambiguous) const {
+			ambiguous = false;
+			if (name.empty()) return nullptr;
+
+			detail::NameTrie::Match match = longTrie.find(args, name);
+			if (match.id != std::string_view::npos) return deref(args.refs[match.id]);
+
+			ambiguous = !match.candidates.empty();
+			return nullptr;
+		}
+
+		/*
+		 * Report an abbreviated long option name which more than one option
+		 * starts with
+		 *
+		 * prefix	The prefix the name was given with
+		 * name		The name, without its prefix
+		 * Throws ParsingError, listing the candidates.
+		 */
+		void throwAmbiguous(std::string_view prefix, std::string_view name) const {
+			detail::NameTrie::Match match = longTrie.find(args, name);
+
+			std::string msg = "Option " + std::string(prefix) + std::string(name) + " is ambiguous; could be";
+			for (std::uint32_t id : match.candidates) {
+				msg += " " + std::string(prefix) + std::string(args.longName(id));
+			}
+
+			throw ParsingError(msg);
+		}
+	};
+
+	/*
+	 * Any type of argument to be parsed from the command line.
+	 */
+	class AbstractArgument {
+		friend class AbstractParser;
+
+		template <auto... Members>
+		friend struct ArgumentList;
+
+		template <typename T>
+		friend class detail::Dispatcher;
+
+	private:
+		// Offset of the parser from this argument, so that it stays valid when
+		// the parser is moved
+		std::ptrdiff_t parserOffset;
+
+		// Position of this argument in its parser's presence bitset
+		std::size_t id = 0;
+
+	protected:
+		std::pmr::string help;
+
+		/*
+		 * Construct an argument
+		 *
+		 * parser	The parser the argument belongs to
+		 * kind		The kind of argument
+		 * help		A help string
+		 * arity	How many values the argument takes
+		 */
+		AbstractArgument(AbstractParser *parser, ArgKind kind, std::string_view help, Arity arity = Arity::one)
+			: parserOffset(reinterpret_cast<char *>(parser) - reinterpret_cast<char *>(this)),
+			  help(help, parser->resource), kind(kind), arity(arity) {}
+
+		/*
+		 * Get the parser this argument belongs to
+		 */
+		AbstractParser *getParser() const {
+			return reinterpret_cast<AbstractParser *>(const_cast<char *>(reinterpret_cast<const char *>(this)) + parserOffset);
+		}
+
+		/*
+		 * Add this to the specified parser as a positional argument
+		 *
+		 * parser	The parser to add this argument to
+		 * variadic	Whether this argument takes all remaining positional
+		 * 			arguments
+		 * Throws std::invalid_argument if a variadic positional argument has
+		 * already been added.
+		 */
+		void addToParser(AbstractParser *parser, bool variadic) {
+			if (parser->variadicPositional) {
+				throw std::invalid_argument("Positional arguments cannot follow a variadic one");
+			}
+
+			parser->registerArgument(this, '\0', {});
+			parser->positionals.push_back(parser->refOf(this));
+			parser->variadicPositional = variadic;
+		}
+
+		/*
+		 * Add this to the specified parser, and index it by name
+		 *
+		 * parser		The parser to add this argument to
+		 * shortName	The short name of this argument, or '\0' if it has none
+		 * longName		The long name of this argument, or an empty string if it
+		 * 				has none
+		 * Throws std::invalid_argument if either name is already in use.
+		 */
+		void addToParser(AbstractParser *parser, char shortName, std::string_view longName) {
+			parser->registerArgument(this, shortName, longName);
+			parser->addOption(this, shortName, longName);
+		}
+
+		/*
+		 * Bind this to an environment variable of its parser
+		 *
+		 * variable		The name of the environment variable
+		 * Throws std::invalid_argument if the variable is already bound.
+		 */
+		void bindEnvironment(std::string_view variable) {
+			AbstractParser *parser = getParser();
+
+			if (!parser->environment.bind(parser->refOf(this), variable)) {
+				throw std::invalid_argument("Duplicate environment variable " + std::string(variable));
+			}
+		}
+
+		/*
+		 * Get this argument's short name from its parser's argument table, or
+		 * '\0' if it has none
+		 */
+		char shortName() const {
+			return getParser()->args.shortNames[id];
+		}
+
+		/*
+		 * Get this argument's long name from its parser's argument table, or an
+		 * empty string if it has none
+		 */
+		std::string_view longName() const {
+			return getParser()->args.longName(id);
+		}
+
+		/*
+		 * Construct a value of type U, passing the parser's memory resource to
+		 * it if U is allocator aware.
+		 *
+		 * args		Arguments to U's constructor
+		 */
+		template <typename U, typename... Args>
+		U make(Args&&... args) const {
+			return std::make_obj_using_allocator<U>(std::pmr::polymorphic_allocator<>(getParser()->resource),
+				std::forward<Args>(args)...);
+		}
+
+		/*
+		 * Convert a command line argument to a value of type U. Arithmetic types
+		 * are parsed with detail::parseNumber; other types are constructed from
+		 * the argument, using the parser's memory resource if they are
+		 * allocator aware.
+		 *
+		 * str		The argument
+		 * Throws ParsingError if the argument isn't a valid U.
+		 */
+		template <typename U>
+		U convert(std::string_view str) const {
+			if constexpr (std::is_arithmetic_v<U> && !std::same_as<U, bool>) {
+				U result;
+
+				if (const char *err = detail::parseNumber(str, result)) {
+					throw ParsingError(displayName() + " " + err + ": '" + std::string(str) + "'");
+				}
+
+				return result;
+			} else {
+				return make<U>(str);
+			}
+		}
+
+	public:
+		const ArgKind kind;
+		const Arity arity;
+
+		/*
+		 * Get a description of this argument for messages, e.g. "Option foo"
+		 */
+		virtual std::string displayName() const = 0;
+
+		/*
+		 * Parse an argument and its values. For options, argv[0] is the
+		 * option, which targ::parse has already matched, and the rest are its
+		 * values. For positional arguments, every element is a value. The
+		 * values are those targ::parse found for the argument's arity, and an
+		 * option's value may have been attached to it, as in --output=a.out.
+		 *
+		 * argv		Views of the argument and its values
+		 * Returns the number of elements consumed from argv. Returning 0
+		 * indicates no arguments were parsed.
+		 * Throws ParsingError when this option is present but malformed.
+		 */
+		virtual int parseArg(std::span<const std::string_view> argv) = 0;
+
+		/*
+		 * Parse the value of an environment variable bound to this argument
+		 *
+		 * value	The variable's value
+		 * Throws ParsingError if the value is malformed.
+		 */
+		virtual void parseVariable(std::string_view) {}
+
+		/*
+		 * Turn the argument off, as when the style's negation prefix is given
+		 * instead of its prefix, e.g. +sb
+		 *
+		 * Returns false if the argument can't be turned off.
+		 */
+		virtual bool negate() { return false; }
+
+		/*
+		 * Convert anything parseArg left unconverted
+		 *
+		 * Throws ParsingError if it is malformed.
+		 */
+		virtual void validate() const {}
+
+		/*
+		 * Make room for a number of values before parsing, for arguments which
+		 * collect several. Called by targ::parse once it knows how many values
+		 * follow each occurrence of the argument.
+		 *
+		 * n		The number of values to make room for
+		 */
+		virtual void reserveValues(std::size_t) {}
+	};
+
+	inline bool AbstractParser::isPresent(const AbstractArgument &arg) const {
+		return present[arg.id];
+	}
+
+	inline void AbstractParser::validateAll() const {
+		for (detail::ArgRef ref : args.refs) {
+			deref(ref)->validate();
+		}
+	}
+
+	inline void AbstractParser::registerArgument(AbstractArgument *arg, char shortName, std::string_view longName) {
+		arg->id = args.add(refOf(arg), arg->kind, shortName, longName);
+		present.push_back(false);
+	}
+
+	inline void AbstractParser::addOption(AbstractArgument *arg, char shortName, std::string_view longName) {
+		detail::ArgRef ref = refOf(arg);
+
+		if (shortName != '\0') {
+			detail::ArgRef &slot = shortIndex[static_cast<unsigned char>(shortName)];
+
+			if (slot) {
+				throw std::invalid_argument(std::string("Duplicate option ") + shortName);
+			}
+
+			slot = ref;
+		}
+
+		if (!longName.empty() && !args.indexLong(arg->id)) {
+			throw std::invalid_argument(std::string("Duplicate option ") + std::string(longName));
+		}
+	}
+
+	inline std::size_t AbstractParser::idOf(const AbstractArgument *arg) const {
+		return arg->id;
+	}
+
+	inline void AbstractParser::markPresent(AbstractArgument *arg) {
+		present[arg->id] = true;
+	}
+
+	inline void AbstractParser::applyEnvironment() {
+		if (environment.size() == 0) return;
+
+		for (char **var = detail::environment(); var && *var; ++var) {
+			std::string_view entry(*var);
+			std::size_t eq = entry.find('=');
+			if (eq == std::string_view::npos) continue;
+
+			std::size_t i = environment.find(entry.substr(0, eq));
+			if (i == environment.size()) continue;
+
+			// The command line takes precedence
+			AbstractArgument *arg = deref(environment.refs[i]);
+			if (present[arg->id]) continue;
+
+			try {
+				arg->parseVariable(entry.substr(eq + 1));
+			} catch (const ParsingError &e) {
+				throw ParsingError(std::string(e.what()) + " (from " + std::string(environment.name(i)) + ")");
+			}
+		}
+	}
+
+	/*
+	 * A positional argument
+	 *
+	 * Positional arguments are filled in the order they are declared, from the
+	 * arguments which aren't options. The argument is converted to T in the
+	 * same way as for Option.
+	 * For any vector type, the argument is variadic, and collects every
+	 * remaining positional argument. It must be the last positional argument
+	 * declared.
+	 */
+	template <typename T>
+	class PositionalArgument : public AbstractArgument {
+	protected:
+		std::pmr::string name;
+		T value;
+
+	public:
+		/*
+		 * Construct a new positional argument
+		 *
+		 * parser	The parser to add the argument to
+		 * name		The name of the argument
+		 * help		A help string
+		 */
+		PositionalArgument(AbstractParser *parser, std::string_view name, std::string_view help)
+				: AbstractArgument(parser, ArgKind::positional, help, detail::is_vector<T>::value ? Arity::many : Arity::one),
+				  name(name, parser->resource), value(make<T>()) {
+			addToParser(parser, detail::is_vector<T>::value);
+		}
+
+		PositionalArgument<T> &operator=(const T &v) {
+			value = v;
+			return *this;
+		}
+
+		virtual std::string displayName() const {
+			return "Argument " + std::string(name);
+		}
+
+		virtual int parseArg(std::span<const std::string_view> argv) {
+			if constexpr (detail::is_vector<T>::value) {
+				// Take the whole run of positional arguments
+				value.reserve(value.size() + argv.size());
+
+				for (std::string_view arg : argv) {
+					value.push_back(convert<typename T::value_type>(arg));
+				}
+
+				return argv.size();
+			} else {
+				value = convert<T>(argv[0]);
+				return 1;
+			}
+		}
+	};
+
+	/*
+	 * An option
+	 *
+	 * Some type specializations of this class change how option arguments are
+	 * parsed from the command line.
+	 * For most types, the next command line argument is cast to T from a
+	 * std::string_view (and so a user conversion operator must be defined if it
+	 * isn't already).
+	 * For std::string_view, the value is a view of the argument in argv, so no
+	 * copy of it is made.
+	 * For arithmetic types, the argument is parsed as a number, which may have
+	 * a base prefix (0x, 0o, 0b) and a unit suffix (k, M, G, s, ms). See
+	 * detail::parseNumber.
+	 * For booleans, the option is treated as a switch. By default the option's
+	 * value is false, and it is true if the switch is specified on the command
+	 * line.
+	 * For any vector type, zero or more arguments are parsed after the option,
+	 * up to the next argument which looks like an option. The values are
+	 * appended, so the option may be repeated. See also splitOn.
+	 * For any optional type, the option takes a value only if it is attached,
+	 * as in -O2 or --level=2, following getopt's "::". A separate argument
+	 * after the option is never its value.
+	 * A value attached to the option, as in --output=a.out or -ofile, is always
+	 * taken, even if it looks like an option.
+	 *
+	 * Values of allocator aware types, such as std::pmr::string and
+	 * std::pmr::vector, are allocated from the parser's memory resource.
+	 */
+	template <typename T>
+	class Option : public AbstractArgument {
+	private:
+		static constexpr Arity valueArity = std::same_as<T, bool> ? Arity::none
+			: detail::is_vector<T>::value ? Arity::many
+			: detail::is_optional<T>::value ? Arity::optional
+			: Arity::one;
+
+	protected:
+		T value;
+
+		// Separator for splitting each argument into several values, or '\0'
+		char delimiter = '\0';
+
+	public:
+		/*
+		 * Construct a new option
+		 *
+		 * parser	The parser to add the option to
+		 * s		The short option name
+		 * help		A help string
+		 */
+		Option(AbstractParser *parser, char s, std::string_view help)
+				: AbstractArgument(parser, ArgKind::option, help, valueArity), value(make<T>()) {
+			addToParser(parser, s, {});
+		}
+
+		/*
+		 * Construct a new option
+		 *
+		 * parser	The parser to add the option to
+		 * l		The long option name
+		 * help		A help string
+		 */
+		Option(AbstractParser *parser, std::string_view l, std::string_view help)
+				: AbstractArgument(parser, ArgKind::option, help, valueArity), value(make<T>()) {
+			addToParser(parser, '\0', l);
+		}
+
+		/*
+		 * Construct a new option
+		 *
+		 * parser	The parser to add the option to
+		 * s		The short option name
+		 * l		The long option name
+		 * help		A help string
+		 */
+		Option(AbstractParser *parser, char s, std::string_view l, std::string_view help)
+				: AbstractArgument(parser, ArgKind::option, help, valueArity), value(make<T>()) {
+			addToParser(parser, s, l);
+		}
+
+		Option<T> &operator=(const T &v) {
+			value = v;
+			return *this;
+		}
+
+		/*
+		 * Split each argument of a vector option into several values, e.g.
+		 * "a,b,c" into "a", "b" and "c". The pieces are converted directly from
+		 * views of the argument.
+		 *
+		 * delim	The separator, or '\0' to not split arguments
+		 */
+		void splitOn(char delim) requires detail::is_vector<T>::value {
+			delimiter = delim;
+		}
+
+		/*
+		 * Take the option's value from an environment variable when it isn't
+		 * given on the command line, e.g. APP_OUTPUT for --output. The
+		 * variable's value is converted as the option's argument would be;
+		 * switches accept 1/0, true/false, yes/no and on/off. targ::parse
+		 * reads the environment after the command line, and the option is
+		 * still not present as far as AbstractParser::isPresent is concerned.
+		 *
+		 * variable		The name of the environment variable
+		 * Throws std::invalid_argument if the variable is already bound.
+		 */
+		void fromEnv(std::string_view variable) {
+			bindEnvironment(variable);
+		}
+
+		virtual void parseVariable(std::string_view str) {
+			if constexpr (std::same_as<T, bool>) {
+				if (const char *err = detail::parseFlag(str, value)) {
+					throw ParsingError(displayName() + " " + err + ": '" + std::string(str) + "'");
+				}
+			} else if constexpr (detail::is_vector<T>::value) {
+				appendValues(str);
+			} else if constexpr (detail::is_optional<T>::value) {
+				value = convert<typename T::value_type>(str);
+			} else {
+				value = convert<T>(str);
+			}
+		}
+
+		virtual bool negate() {
+			if constexpr (std::same_as<T, bool>) {
+				value = false;
+				return true;
+			} else {
+				return false;
+			}
+		}
+
+		virtual void reserveValues(std::size_t n) {
+			if constexpr (detail::is_vector<T>::value) {
+				value.reserve(value.size() + n);
+			}
+		}
+
+		virtual std::string displayName() const {
+			return "Option " + (longName().empty() ? std::string(1, shortName()) : std::string(longName()));
+		}
+
+		/*
+		 * Append the values in an argument to a vector option, splitting it on
+		 * the delimiter if there is one.
+		 *
+		 * str		The argument
+		 */
+		void appendValues(std::string_view str) requires detail::is_vector<T>::value {
+			using U = typename T::value_type;
+
+			if (!delimiter) {
+				value.push_back(convert<U>(str));
+				return;
+			}
+
+			for (std::size_t start = 0; ; ) {
+				std::size_t end = str.find(delimiter, start);
+				value.push_back(convert<U>(str.substr(start, end - start)));
+
+				if (end == std::string_view::npos) break;
+				start = end + 1;
+			}
+		}
+
+		virtual int parseArg(std::span<const std::string_view> argv) {
+			if constexpr (std::same_as<T, bool>) {
+				// handle switches
+				value = true;
+				return 1;
+			} else if constexpr (detail::is_vector<T>::value) {
+				// handle option with multiple args. Count the values first, so
+				// the vector only has to grow once.
+				std::size_t count = 0;
+
+				for (std::string_view arg : argv.subspan(1)) {
+					count += delimiter ? std::ranges::count(arg, delimiter) + 1 : 1;
+				}
+
+				value.reserve(value.size() + count);
+
+				for (std::string_view arg : argv.subspan(1)) {
+					appendValues(arg);
+				}
+
+				return argv.size();
+			} else if constexpr (detail::is_optional<T>::value) {
+				// handle option with an optional attached arg. The value stays
+				// empty if there is no arg; use AbstractParser::isPresent to
+				// tell whether the option was given.
+				if (argv.size() > 1) {
+					value = convert<typename T::value_type>(argv[1]);
+					return 2;
+				}
+
+				return 1;
+			} else {
+				// default option type
+				if (argv.size() > 1) {
+					value = convert<T>(argv[1]);
+					return 2;
+				} else {
+					throw ParsingError(displayName() + " expects one argument!");
+				}
+			}
+		}
+	};
+
+	/*
+	 * An option which takes no parameters. Its presence or absence indicates a
+	 * true or false value.
+	 */
+	typedef Option<bool> Switch;
+
+	/*
+	 * An option whose value is converted when it is first read, rather than
+	 * while parsing. Parsing only records a view of the argument in argv, so
+	 * options the program never reads cost nothing to convert. The converted
+	 * value is cached.
+	 *
+	 * T may be any type Option accepts with exactly one argument; switches,
+	 * vectors and optionals are parsed eagerly by Option. A malformed
+	 * argument throws ParsingError when the value is read, or from
+	 * AbstractParser::validateAll.
+	 */
+	template <typename T>
+	class LazyOption : public AbstractArgument {
+		static_assert(!std::same_as<T, bool> && !detail::is_vector<T>::value && !detail::is_optional<T>::value,
+			"LazyOption takes exactly one argument; use Option for this type");
+
+	protected:
+		// The argument, as a view of argv
+		std::string_view raw;
+
+		// The converted value, or the default if the option wasn't given.
+		// Empty until the argument is converted.
+		mutable std::optional<T> value;
+
+	public:
+		/*
+		 * Construct a new lazy option
+		 *
+		 * parser	The parser to add the option to
+		 * s		The short option name
+		 * help		A help string
+		 */
+		LazyOption(AbstractParser *parser, char s, std::string_view help)
+				: AbstractArgument(parser, ArgKind::option, help), value(make<T>()) {
+			addToParser(parser, s, {});
+		}
+
+		/*
+		 * Construct a new lazy option
+		 *
+		 * parser	The parser to add the option to
+		 * l		The long option name
+		 * help		A help string
+		 */
+		LazyOption(AbstractParser *parser, std::string_view l, std::string_view help)
+				: AbstractArgument(parser, ArgKind::option, help), value(make<T>()) {
+			addToParser(parser, '\0', l);
+		}
+
+		/*
+		 * Construct a new lazy option
+		 *
+		 * parser	The parser to add the option to
+		 * s		The short option name
+		 * l		The long option name
+		 * help		A help string
+		 */
+		LazyOption(AbstractParser *parser, char s, std::string_view l, std::string_view help)
+				: AbstractArgument(parser, ArgKind::option, help), value(make<T>()) {
+			addToParser(parser, s, l);
+		}
+
+		/*
+		 * Set the default value, used if the option isn't given
+		 */
+		LazyOption<T> &operator=(const T &v) {
+			value = v;
+			return *this;
+		}
+
+		/*
+		 * Get the value, converting the argument the first time it is read
+		 *
+		 * Throws ParsingError if the argument isn't a valid T.
+		 */
+		const T &get() const {
+			if (!value) value.emplace(convert<T>(raw));
+			return *value;
+		}
+
+		virtual std::string displayName() const {
+			return "Option " + (longName().empty() ? std::string(1, shortName()) : std::string(longName()));
+		}
+
+		virtual void validate() const {
+			get();
+		}
 
-	/*
-	 * An exception thrown when parsing is invalid. This exception is used to
-	 * signal invalid user input.
-	 */
-	class ParsingError : public std::runtime_error {
-	public:
-		ParsingError(std::string msg) : std::runtime_error(msg) {}
-		const char *what() const throw() { return std::runtime_error::what(); }
+		virtual int parseArg(std::span<const std::string_view> argv) {
+			if (argv.size() < 2) throw ParsingError(displayName() + " expects one argument!");
+
+			raw = argv[1];
+			value.reset();
+			return 2;
+		}
 	};
 
 	/*
-	 * Abstract parser class. All parsers should inherit from this class.
+	 * A list of a parser's arguments, as pointers to members. A parser which
+	 * declares one as its "arguments" type is parsed without virtual calls:
+	 * targ::parse finds the argument's position in the list and calls the
+	 * concrete parseArg directly, so each argument's conversion can be
+	 * inlined. Arguments missing from the list are still parsed through
+	 * AbstractArgument.
 	 *
-	 * Specialized program argument parsers are created by subclassing this
-	 * class and adding member variables of an AbstractArgument type. Default
-	 * values should be set in the constructor.
+	 * For example:
+	 *	struct MyParser : targ::UnixParser {
+	 *		targ::Switch verbose{this, 'v', "verbose", "Show verbose output"};
+	 *		targ::Option<int> level{this, 'l', "level", "Set the level"};
+	 *
+	 *		using arguments = targ::ArgumentList<&MyParser::verbose, &MyParser::level>;
+	 *	};
+	 *
+	 * Members	Pointers to the argument members
 	 */
-	class AbstractParser {
-		friend class AbstractArgument;
-
-		template <typename T>
-		friend T parse(int argc, char **argv) requires std::derived_from<T, AbstractParser>;
-
-	protected:
-		std::string prgmName;
-
-		// is it possible to populate this at compile time?
-		std::vector<AbstractArgument *> args;
-
-	public:
-		const std::string shortOptPrefix;
-		const std::string longOptPrefix;
+	template <auto... Members>
+	struct ArgumentList {
+		static constexpr std::size_t size = sizeof...(Members);
 
 		/*
-		 * Parse meta arguments; that is 'arguments' which inform the parser on
-		 * how to parse future arguments.
+		 * Map each listed argument's registration id to its position in this
+		 * list.
 		 *
-		 * arg		The meta-argument.
-		 * Returns true if the argument was consumed, false otherwise.
+		 * parser	The parser
+		 * table	Indexed by argument id. Set to the position of the argument
+		 * 			in this list, for listed arguments.
 		 */
-		virtual bool metaparser(std::string arg) { return false; }
+		template <typename T>
+		static void indexIds(T &parser, std::span<std::uint16_t> table) {
+			std::uint16_t i = 0;
+			((table[(parser.*Members).id] = i++), ...);
+		}
 
 		/*
-		 * Discriminate arguments out of args. This is intended to be used in
-		 * conjunction with metaparser to selectively parse certain types of
-		 * arguments dependent on meta args.
+		 * Parse an argument without a virtual call
 		 *
-		 * arg		A pointer to the argument which the parser wants to test.
-		 * Returns true if the parser should test for this argument, and false
-		 * if it shouldn't.
+		 * parser	The parser
+		 * i		The position of the argument in this list
+		 * argv		As for AbstractArgument::parseArg
 		 */
-		virtual bool shouldTest(AbstractArgument *arg) { return true; }
+		template <typename T>
+		static int parseArg(T &parser, std::size_t i, std::span<const std::string_view> argv) {
+			// One entry point per argument, indexed like Members
+			static constexpr std::array<int (*)(T &, std::span<const std::string_view>), size> parsers{
+				&callParseArg<Members, T>...
+			};
+
+			return parsers[i](parser, argv);
+		}
+
+	private:
+		template <auto Member, typename T>
+		static int callParseArg(T &parser, std::span<const std::string_view> argv) {
+			using A = std::remove_reference_t<decltype(parser.*Member)>;
+
+			// A qualified call is not virtual
+			return (parser.*Member).A::parseArg(argv);
+		}
 	};
 
-	/*
-	 * Any type of argument to be parsed from the command line.
-	 */
-	class AbstractArgument {
-	protected:
-		std::string help;
-		AbstractParser *parser;
+	namespace detail {
+		/*
+		 * Calls parseArg on a parser's arguments. Without an ArgumentList this
+		 * is a virtual call.
+		 */
+		template <typename T>
+		class Dispatcher {
+		public:
+			explicit Dispatcher(T &) {}
+
+			int parseArg(T &, AbstractArgument *arg, std::span<const std::string_view> argv) {
+				return arg->parseArg(argv);
+			}
+		};
+
+		template <typename T> requires requires { T::arguments::size; }
+		class Dispatcher<T> {
+		private:
+			// Position in the ArgumentList of each argument, by argument id
+			std::pmr::vector<std::uint16_t> positions;
+
+		public:
+			explicit Dispatcher(T &parser) : positions(parser.present.size(), T::arguments::size, parser.resource) {
+				T::arguments::indexIds(parser, positions);
+			}
+
+			int parseArg(T &parser, AbstractArgument *arg, std::span<const std::string_view> argv) {
+				std::size_t i = positions[arg->id];
+
+				if (i == T::arguments::size) return arg->parseArg(argv);
+				return T::arguments::parseArg(parser, i, argv);
+			}
+		};
 
 		/*
-		 * Add this to the specified parser
+		 * Count the arguments after one which an argument takes as its values.
+		 * A variable number of values ends at the first argument which wasn't
+		 * lexed as positional.
 		 *
-		 * parser	The parser to add this argument to
+		 * arity	The argument's arity
+		 * lexed	The records of the command line arguments from lexTokens
+		 * i		The index of the argument, or of its first value for a
+		 * 			positional argument
 		 */
-		void addToParser(AbstractParser *parser) {
-			parser->args.push_back(this);
-		}
+		inline std::size_t countValues(Arity arity, std::span<const LexedToken> lexed, std::size_t i) {
+			std::size_t end = i + 1;
 
-	public:
-		const any_tag tag{};
+			switch (arity) {
+				case Arity::none:
+				case Arity::optional:
+					break;
+				case Arity::one:
+					end = std::min(end + 1, lexed.size());
+					break;
+				case Arity::many:
+					while (end < lexed.size() && lexed[end].kind == TokenKind::positional) ++end;
+					break;
+				case Arity::rest:
+					end = lexed.size();
+					break;
+			}
+
+			return end - i - 1;
+		}
 
 		/*
-		 * Parse argument from beginning of argv
+		 * Classify arguments in one pass, before any is dispatched. Each
+		 * argument's name and any attached value are found, and the option it
+		 * names is looked up. Arguments after the style's terminator are
+		 * positional, as are unknown long options if the parser hides
+		 * unknownLongOptionsArePositional with true. An ambiguous abbreviation is only recorded, since the
+		 * argument may turn out to be another option's value. Options which
+		 * take a vector of values are then told how many values they will be
+		 * given in total, so each is sized once.
 		 *
-		 * argc		Count of elements after argv
-		 * argv		Array of strings to parse the argument from
-		 * Returns the number of elements consumed from argv. Returning 0
-		 * indicates no arguments were parsed.
-		 * Throws ParsingError when this option is present but malformed.
+		 * Positional arguments are followed through the parser's positional
+		 * slots. Lexing stops at the argument which fills a slot that takes
+		 * every remaining argument, such as a subcommand, since those belong
+		 * to another parser.
+		 *
+		 * parser	The parser
+		 * args		Views of the command line arguments
+		 * lexed	Set to one record per argument
+		 * start	The index of the first argument to lex
+		 * Returns the index of the argument which fills a slot taking every
+		 * remaining argument, or args.size(). Arguments after it aren't lexed.
 		 */
-		virtual int parseArg(int argc, char **argv) = 0;
-	};
+		template <typename T>
+		std::size_t lexTokens(T &parser, std::span<const std::string_view> args, std::pmr::vector<LexedToken> &lexed,
+				std::size_t start) {
+			lexed.resize(args.size());
+			std::size_t i = start;
+			std::size_t end = args.size();
 
-	template <typename T>
-	class PositionalArgument : public AbstractArgument {
-	protected:
-		std::string name;
-		T value;
+			// The next positional slot, and what the arguments after an option
+			// or a positional argument take as their values: a single argument
+			// of any kind, or a run of positional arguments
+			std::size_t slot = parser.nextPositional;
+			bool value = false;
+			bool run = false;
 
-	public:
-		const any_tag tag = positional_tag();
+			for (; i < args.size(); ++i) {
+				Token token = parser.optionStyle.classify(args[i]);
+				LexedToken &record = lexed[i];
 
-		PositionalArgument<T> &operator=(const T &v) {
-			value = v;
-			return *this;
-		}
+				record.kind = token.kind;
+				LongToken split{token.name, {}, false};
 
-		virtual int parseArg(int argc, char **argv) {
-			return 0;
-		}
-	};
+				if (token.kind != TokenKind::positional && token.kind != TokenKind::terminator) {
+					if constexpr (!T::longValueSeparators.empty()) {
+						if (token.kind == TokenKind::longOption) split = splitLongToken(token.name, T::longValueSeparators);
+					}
 
-	/*
-	 * An option
-	 *
-	 * Some type specializations of this class change how option arguments are
-	 * parsed from the command line.
-	 * For most types, the next command line argument is cast to T (and so a
-	 * user conversion operator must be defined if it isn't already).
-	 * For booleans, the option is treated as a switch. By default the option's
-	 * value is false, and it is true if the switch is specified on the command
-	 * line.
-	 * For any vector type, zero or more arguments are parsed after the option.
-	 * For any optional type, zero or one arguments are parsed after the option
-	 */
-	template <typename T>
-	class Option : public AbstractArgument {
-	protected:
-		char shortName;
-		std::string longName;
-		T value;
+					record.hasValue = split.hasValue;
+					record.nameOffset = args[i].length() - token.name.length();
+					record.nameLength = split.name.length();
 
-		constexpr bool doesStrMatchOption(std::string str) {
-			return ((str.starts_with(parser->shortOptPrefix) && str[parser->shortOptPrefix.length()] == shortName)
-				|| (str.starts_with(parser->longOptPrefix) && str.substr(parser->longOptPrefix.length()) == longName));
-		}
+					if (token.kind == TokenKind::shortOption) {
+						record.option = parser.findShortOption(split.name[0]);
+					} else {
+						record.option = parser.findLongOption(split.name);
+						if (!record.option && parser.allowAbbreviations) {
+							record.option = parser.findAbbreviation(split.name, record.ambiguous);
+						}
+					}
 
-	public:
-		const any_tag tag = option_tag();
+					if constexpr (T::unknownLongOptionsArePositional) {
+						if (token.kind == TokenKind::longOption && !record.option && !record.ambiguous) record = LexedToken{};
+					}
+				}
+
+				// A terminator which is an option's value doesn't end options
+				bool taken = value || (run && record.kind == TokenKind::positional);
+				if (record.kind == TokenKind::terminator && !taken) break;
+
+				value = false;
+				run = run && taken;
+				if (record.kind == TokenKind::terminator) continue;
+
+				if (record.kind == TokenKind::positional) {
+					if (taken || slot >= parser.positionals.size()) continue;
+
+					AbstractArgument *arg = parser.deref(parser.positionals[slot]);
+					if (arg->arity == Arity::rest) {
+						end = i;
+						break;
+					}
+
+					run = arg->arity == Arity::many;
+					if (!parser.variadicPositional || slot + 1 < parser.positionals.size()) ++slot;
+					continue;
+				}
+
+				if (taken || record.hasValue || token.kind == TokenKind::negatedOption) continue;
+
+				// Only the last option of a cluster of switches takes the
+				// arguments after it
+				AbstractArgument *opt = record.option;
+				if (token.kind == TokenKind::shortOption && split.name.length() > 1) {
+					std::size_t k = 0;
+
+					if constexpr (T::clusterShortOptions) {
+						while (opt && opt->arity == Arity::none && ++k < split.name.length()) {
+							opt = parser.findShortOption(split.name[k]);
+						}
+					}
+
+					if (k + 1 < split.name.length()) opt = nullptr;
+				}
+
+				if (opt) {
+					value = opt->arity == Arity::one;
+					run = opt->arity == Arity::many;
+				}
+			}
+
+			// Everything after the terminator is positional, and already
+			// value-initialized as such
+
+			// Count the values which follow every occurrence of each option
+			std::pmr::vector<std::size_t> counts(parser.present.size(), 0, parser.resource);
+
+			for (std::size_t j = start; j < i && j < args.size(); ++j) {
+				AbstractArgument *opt = lexed[j].option;
+				if (!opt || lexed[j].kind == TokenKind::negatedOption) continue;
+				if (lexed[j].kind == TokenKind::shortOption && lexed[j].nameLength != 1) continue;
+
+				counts[parser.idOf(opt)] += lexed[j].hasValue ? 1 : countValues(opt->arity, lexed, j);
+			}
+
+			for (std::size_t id = 0; id < counts.size(); ++id) {
+				if (counts[id]) parser.deref(parser.args.refs[id])->reserveValues(counts[id]);
+			}
+
+			return end;
+		}
 
 		/*
-		 * Construct a new option
+		 * Parse a short option. If the parser clusters short options, this may
+		 * be several short options, such as -abc, or a short option with its
+		 * value attached, such as -ofile. A cluster is decoded in one pass,
+		 * looking each character up in the short option table. The first
+		 * option which takes a value takes the rest of the token, whatever it
+		 * is, and ends the cluster; the last option in the cluster may take
+		 * the arguments which follow.
 		 *
-		 * parser	The parser to add the option to
-		 * s		The short option name
-		 * help		A help string
+		 * parser		The parser
+		 * dispatcher	Calls parseArg on the parser's arguments
+		 * args			Views of the command line arguments
+		 * lexed		The records of the arguments from lexTokens
+		 * i			The index of the token in args
+		 * Returns the number of arguments consumed, or 0 if the token doesn't
+		 * start with one of the parser's short options.
 		 */
-		Option(AbstractParser *parser, char s, std::string help) : shortName(s) {
-			this->help = help;
-			this->parser = parser;
+		template <typename T>
+		std::size_t parseShortOption(T &parser, Dispatcher<T> &dispatcher, std::span<const std::string_view> args,
+				std::span<const LexedToken> lexed, std::size_t i) {
+			const LexedToken &record = lexed[i];
+			std::string_view name = args[i].substr(record.nameOffset);
+			AbstractArgument *opt = record.option;
+			if (!opt || !parser.shouldTest(opt)) return 0;
+
+			for (std::size_t k = 0; ; ) {
+				std::string_view rest = name.substr(k + 1);
+
+				if (rest.empty()) {
+					std::size_t values = countValues(opt->arity, lexed, i);
+					int argsConsumed = dispatcher.parseArg(parser, opt, args.subspan(i, 1 + values));
+					parser.markPresent(opt);
+					return argsConsumed;
+				}
+
+				if constexpr (!T::clusterShortOptions) {
+					return 0;
+				} else {
+					std::array<std::string_view, 2> attached{name.substr(k, 1), rest};
+
+					if (opt->arity != Arity::none) {
+						// The option takes the rest of the token as its value
+						dispatcher.parseArg(parser, opt, attached);
+						parser.markPresent(opt);
+						return 1;
+					}
+
+					dispatcher.parseArg(parser, opt, std::span(attached).first(1));
+					parser.markPresent(opt);
 
-			addToParser(parser);
+					opt = parser.findShortOption(name[++k]);
+					if (!opt || !parser.shouldTest(opt)) {
+						// The options before this one were applied, so only the
+						// rest of the cluster is unknown
+						std::pmr::string &unknown = parser.unknownClusters.emplace_back(args[i].substr(0, record.nameOffset));
+						unknown += name.substr(k);
+
+						handleUnknown(parser, unknown, record);
+						return 1;
+					}
+				}
+			}
 		}
 
 		/*
-		 * Construct a new option
+		 * Parse a long option. If the parser accepts attached values, its value
+		 * may follow an '=', as in --output=a.out; the name and value are then
+		 * both views of the token, so nothing is copied. A long option given
+		 * with the style's negation prefix, as in +sb, is turned off instead.
 		 *
-		 * parser	The parser to add the option to
-		 * l		The long option name
-		 * help		A help string
+		 * parser		The parser
+		 * dispatcher	Calls parseArg on the parser's arguments
+		 * args			Views of the command line arguments
+		 * lexed		The records of the arguments from lexTokens
+		 * i			The index of the token in args
+		 * Returns the number of arguments consumed, or 0 if the token doesn't
+		 * name one of the parser's long options.
+		 * Throws ParsingError if the name is an ambiguous abbreviation, if a
+		 * value is attached to an option which doesn't take one, or if an
+		 * option which can't be turned off is negated.
 		 */
-		Option(AbstractParser *parser, std::string l, std::string help) : longName(l) {
-			this->help = help;
-			this->parser = parser;
+		template <typename T>
+		std::size_t parseLongOption(T &parser, Dispatcher<T> &dispatcher, std::span<const std::string_view> args,
+				std::span<const LexedToken> lexed, std::size_t i) {
+			const LexedToken &record = lexed[i];
+			if (record.ambiguous) {
+				std::string_view token = args[i];
+				parser.throwAmbiguous(token.substr(0, record.nameOffset), token.substr(record.nameOffset, record.nameLength));
+			}
+
+			AbstractArgument *opt = record.option;
+			if (!opt || !parser.shouldTest(opt)) return 0;
+
+			if (record.kind == TokenKind::negatedOption) {
+				if (!opt->negate()) throw ParsingError(opt->displayName() + " can't be turned off");
+
+				parser.markPresent(opt);
+				return 1;
+			}
+
+			int argsConsumed;
+			if (record.hasValue) {
+				// The prefix and name are the start of the token
+				std::string_view token = args[i];
+				std::size_t nameEnd = record.nameOffset + record.nameLength;
+				std::array<std::string_view, 2> attached{token.substr(0, nameEnd), token.substr(nameEnd + 1)};
+
+				if (opt->arity == Arity::none) {
+					throw ParsingError(opt->displayName() + " doesn't take a value");
+				}
+
+				// An attached value is always taken, even if it looks like an
+				// option
+				dispatcher.parseArg(parser, opt, attached);
+				argsConsumed = 1;
+			} else {
+				std::size_t values = countValues(opt->arity, lexed, i);
+				argsConsumed = dispatcher.parseArg(parser, opt, args.subspan(i, 1 + values));
+			}
 
-			addToParser(parser);
+			parser.markPresent(opt);
+			return argsConsumed;
 		}
 
 		/*
-		 * Construct a new option
+		 * Apply a parser's UnknownPolicy to an argument nothing accepted
 		 *
-		 * parser	The parser to add the option to
-		 * s		The short option name
-		 * l		The long option name
-		 * help		A help string
+		 * parser	The parser
+		 * arg		The argument
+		 * record	The argument's record from lexTokens
+		 * Throws ParsingError under UnknownPolicy::error, suggesting the
+		 * closest long option name if the argument was lexed as one.
 		 */
-		Option(AbstractParser *parser, char s, std::string l, std::string help) : shortName(s), longName(l) {
-			this->help = help;
-			this->parser = parser;
+		template <typename T>
+		void handleUnknown(T &parser, std::string_view arg, const LexedToken &record) {
+			switch (parser.unknownPolicy) {
+				case UnknownPolicy::collect:
+					parser.unknown.push_back(arg);
+					return;
+				case UnknownPolicy::ignore:
+					return;
+				case UnknownPolicy::error:
+					break;
+			}
 
-			addToParser(parser);
-		}
+			if (record.kind == TokenKind::positional) {
+				throw ParsingError("Unexpected argument " + std::string(arg));
+			}
 
-		Option<T> &operator=(const T &v) {
-			value = v;
-			return *this;
-		}
+			std::string msg = "Unknown option " + std::string(arg);
 
-		virtual int parseArg(int argc, char **argv) {
-			if (doesStrMatchOption(argv[0])) {
-				if constexpr (std::same_as<T, bool>) {
-					// handle switches
-					value = true;
-					return 1;
-				} else if constexpr (std::same_as<T, std::vector<typename T::value_type>>) {
-					// handle option with multiple args
-				} else if constexpr (std::same_as<T, std::optional<typename T::value_type>>) {
+			if (record.kind == TokenKind::longOption || record.kind == TokenKind::negatedOption) {
+				std::string_view suggestion = parser.suggestOption(arg.substr(record.nameOffset, record.nameLength));
 
-				} else {
-					// default option type
-					if (argc > 1) {
-						value = static_cast<T>(argv[1]);
-						return 2;
-					} else {
-						throw ParsingError(std::string("Option ") + longName + " expects one argument!");
-					}
+				if (!suggestion.empty()) {
+					msg += ", did you mean " + std::string(arg.substr(0, record.nameOffset)) + std::string(suggestion) + "?";
 				}
 			}
 
-			return 0;
+			throw ParsingError(msg);
 		}
-	};
-
-	/*
-	 * An option which takes no parameters. Its presence or absence indicates a
-	 * true or false value.
-	 */
-	typedef Option<bool> Switch;
+	}
 
 	/*
-	 * Parse program options.
+	 * Parse arguments from any range into an existing parser. The range may
+	 * be produced lazily, e.g. by a generator which yields string_views or C
+	 * strings; it is read once, and only views of its elements are kept, so
+	 * they must outlive the parser's values. Ranges of std::strings must be
+	 * forward ranges, so no element is overwritten by the next.
+	 * Options bound to environment variables which weren't in the range are
+	 * then read from the environment.
 	 *
-	 * T	The parser class. Must be a subclass of AbstractArgument
+	 * T	The parser class. Must be a subclass of AbstractParser
+	 * R	The range type, e.g. std::span<std::string_view>
 	 *
-	 * argc		The number of command line arguments
-	 * argv		The command line arguments
+	 * parser	The parser to parse into
+	 * tokens	The arguments, without the program name
 	 */
-	template <typename T>
-	T parse(int argc, char **argv) requires std::derived_from<T, AbstractParser> {
-		T parser;
+	template <typename T, detail::token_range R>
+	void parse(T &parser, R &&tokens) requires std::derived_from<T, AbstractParser> {
+		// Views of the arguments, so that no argument is copied while parsing
+		std::pmr::vector<std::string_view> views(parser.resource);
 
-		// Initialize environment vars
-		parser.prgmName = argv[0];
+		if constexpr (std::ranges::sized_range<R>) views.reserve(std::ranges::size(tokens));
+
+		for (auto &&token : tokens) {
+			if (parser.expandArgument) {
+				parser.expandArgument(token, views, parser.retained);
+			} else {
+				views.emplace_back(token);
+			}
+		}
+
+		std::span<const std::string_view> args(views);
+
+		detail::Dispatcher<T> dispatcher(parser);
+
+		if (parser.allowAbbreviations) parser.longTrie.build(parser.args, T::caseInsensitive);
+
+		// Every argument is classified before any is dispatched, up to one
+		// which another parser takes with the rest
+		std::pmr::vector<detail::LexedToken> lexed(parser.resource);
+		std::size_t lexedEnd = detail::lexTokens(parser, args, lexed, 0);
+
+		for (std::size_t i=0; i < args.size(); ) {
+			// The slot expected to take the rest of the arguments didn't, so
+			// the rest must be lexed after all
+			if (i > lexedEnd) lexedEnd = detail::lexTokens(parser, args, lexed, i);
 
-		for (int i=0; i < argc; ) {
 			// metaparsing
-			if (parser.metaparser(argv[i])) {
+			if (parser.metaparser(args[i])) {
 				// metaparser parsed something; move on to next argument
 				++i;
 				continue;
 			}
 
-			for (AbstractArgument *arg : parser.args) {
+			// Only the option the argument names is tested
+			std::size_t argsConsumed = 0;
+
+			switch (lexed[i].kind) {
+				case TokenKind::shortOption:
+					argsConsumed = detail::parseShortOption(parser, dispatcher, args, lexed, i);
+					break;
+				case TokenKind::longOption:
+				case TokenKind::negatedOption:
+					argsConsumed = detail::parseLongOption(parser, dispatcher, args, lexed, i);
+					break;
+				case TokenKind::terminator:
+					// Nothing after this is an option
+					argsConsumed = 1;
+					break;
+				case TokenKind::positional:
+					break;
+			}
+
+			if (argsConsumed != 0) {
+				i += argsConsumed;
+				continue;
+			}
+
+			// A positional token fills the next positional argument. An option
+			// which nothing accepted is unknown, even if a slot is free.
+			if (lexed[i].kind == TokenKind::positional && parser.nextPositional < parser.positionals.size()) {
+				AbstractArgument *arg = parser.deref(parser.positionals[parser.nextPositional]);
+
 				if (parser.shouldTest(arg)) {
-					int argsConsumed = arg->parseArg(argc - i, &argv[i]);
+					// This argument is its first value
+					bool several = arg->arity == Arity::many || arg->arity == Arity::rest;
+					std::size_t values = 1 + (several ? detail::countValues(arg->arity, lexed, i) : 0);
+					int argsConsumed = dispatcher.parseArg(parser, arg, args.subspan(i, values));
 
 					if (argsConsumed != 0) {
 						// An argument was parsed
+						parser.markPresent(arg);
 						i += argsConsumed;
-						break;
+
+						if (!parser.variadicPositional || parser.nextPositional + 1 < parser.positionals.size()) {
+							++parser.nextPositional;
+						}
+
+						continue;
 					}
 				}
-
 			}
+
+			// Nothing accepted the argument. It is always skipped, so parsing
+			// makes progress.
+			detail::handleUnknown(parser, args[i], lexed[i]);
+			++i;
+		}
+
+		// Options bound to environment variables fall back to them
+		parser.applyEnvironment();
+	}
+
+	/*
+	 * Parse program options into an existing parser, without constructing
+	 * anything else.
+	 *
+	 * T	The parser class. Must be a subclass of AbstractParser
+	 *
+	 * parser	The parser to parse into
+	 * argc		The number of command line arguments
+	 * argv		The command line arguments
+	 */
+	template <typename T>
+	void parse(T &parser, int argc, char **argv) requires std::derived_from<T, AbstractParser> {
+		// execve allows an empty argv, without even a program name
+		if (argc < 1) {
+			parse(parser, std::span<char *const>());
+			return;
 		}
 
+		// argv[0] is the program name, so parsing starts after it
+		parser.prgmName = argv[0];
+		parse(parser, std::span<char *const>(argv + 1, argc - 1));
+	}
+
+	/*
+	 * Parse program options.
+	 *
+	 * T	The parser class. Must be a subclass of AbstractParser
+	 *
+	 * argc		The number of command line arguments
+	 * argv		The command line arguments
+	 */
+	template <typename T>
+	T parse(int argc, char **argv) requires std::derived_from<T, AbstractParser> {
+		T parser;
+		parse(parser, argc, argv);
+		return parser;
+	}
+
+	/*
+	 * Parse arguments from any range. See parse(T &, R &&).
+	 *
+	 * T	The parser class. Must be a subclass of AbstractParser
+	 * R	The range type
+	 *
+	 * tokens	The arguments, without the program name
+	 */
+	template <typename T, detail::token_range R>
+	T parse(R &&tokens) requires std::derived_from<T, AbstractParser> {
+		T parser;
+		parse(parser, std::forward<R>(tokens));
+		return parser;
+	}
+
+	/*
+	 * Parse program options, allocating everything from a memory resource.
+	 * With a std::pmr::monotonic_buffer_resource, the whole parse is done with
+	 * one bump allocator and is released in one step when the resource is
+	 * destroyed.
+	 *
+	 * T	The parser class. Must be a subclass of AbstractParser which can
+	 * 		be constructed from a memory resource
+	 *
+	 * argc		The number of command line arguments
+	 * argv		The command line arguments
+	 * resource	The memory resource to allocate from. It must outlive the
+	 * 			parser.
+	 */
+	template <typename T>
+	T parse(int argc, char **argv, std::pmr::memory_resource *resource)
+			requires std::derived_from<T, AbstractParser> && std::constructible_from<T, std::pmr::memory_resource *> {
+		T parser(resource);
+		parse(parser, argc, argv);
 		return parser;
 	}
 }
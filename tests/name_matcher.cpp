@@ -0,0 +1,122 @@
+/*
+ * Checks that every version of detail::NameMatcher the CPU supports gives
+ * exactly the same results as the scalar version, on random inputs of
+ * every length from 0 to 79 at every alignment within 32 bytes. Also
+ * checks splitting a long option at the first of several separators.
+ *
+ * Build and run from the repository root:
+ *	g++ -std=c++20 -O2 -I. -o name_matcher tests/name_matcher.cpp
+ *	./name_matcher
+ * It prints each mismatch and exits with a nonzero status if there are any.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include "targ.hpp"
+
+namespace {
+	struct Version {
+		const char *name;
+		targ::detail::NameMatcher matcher;
+	};
+
+	std::vector<Version> supportedVersions() {
+		std::vector<Version> versions;
+
+#ifdef TARG_X86_SIMD
+		if (__builtin_cpu_supports("sse2")) {
+			versions.push_back({"SSE2", {targ::detail::findSSE2, targ::detail::equalSSE2}});
+		}
+		if (__builtin_cpu_supports("avx2")) {
+			versions.push_back({"AVX2", {targ::detail::findAVX2, targ::detail::equalAVX2}});
+		}
+#endif
+
+		return versions;
+	}
+
+	// Bytes which are likely to repeat, including separators and bytes
+	// with the top bit set, whose sign differs between char and the mask
+	char randomByte(std::mt19937 &rng) {
+		static constexpr char alphabet[] = {'a', 'b', '=', ':', '-', '\0', '\x7f', '\x80', '\xff'};
+		return alphabet[rng() % sizeof alphabet];
+	}
+
+	int failures = 0;
+
+	void fail(const char *version, const char *what, std::size_t offset, std::size_t n) {
+		if (++failures <= 20) std::printf("%s: %s differs at offset %zu, length %zu\n", version, what, offset, n);
+	}
+
+	// The first of several separators in s[0, n), finding each with find
+	std::size_t findFirstOf(const targ::detail::NameMatcher &matcher, const char *s, std::size_t n,
+			std::string_view separators) {
+		std::size_t i = n;
+		for (char c : separators) i = matcher.find(s, i, c);
+		return i;
+	}
+}
+
+int main() {
+	constexpr std::size_t maxLength = 80;
+	constexpr std::size_t alignments = 32;
+	constexpr int rounds = 200;
+
+	const targ::detail::NameMatcher scalar{targ::detail::findScalar, targ::detail::equalScalar};
+	std::vector<Version> versions = supportedVersions();
+	std::mt19937 rng(12345);
+
+	// Room for the longest input at the largest offset
+	std::vector<char> a(maxLength + alignments), b(maxLength + alignments);
+
+	for (int round = 0; round < rounds; ++round) {
+		for (std::size_t offset = 0; offset < alignments; ++offset) {
+			for (std::size_t n = 0; n < maxLength; ++n) {
+				for (std::size_t i = 0; i < a.size(); ++i) a[i] = randomByte(rng);
+
+				// Usually equal, differing in at most one byte
+				std::memcpy(b.data(), a.data(), a.size());
+				if (n && rng() % 2) b[offset + rng() % n] ^= 1 + rng() % 255;
+
+				const char *x = a.data() + offset;
+				const char *y = b.data() + (offset + round) % alignments;
+				std::memmove(b.data() + (offset + round) % alignments, b.data() + offset, n);
+				char needle = randomByte(rng);
+
+				for (const Version &version : versions) {
+					if (version.matcher.find(x, n, needle) != scalar.find(x, n, needle)) {
+						fail(version.name, "find", offset, n);
+					}
+
+					if (version.matcher.equal(x, y, n) != scalar.equal(x, y, n)) {
+						fail(version.name, "equal", offset, n);
+					}
+
+					for (std::string_view separators : {"=", ":=", "=:", "-:="}) {
+						if (findFirstOf(version.matcher, x, n, separators) != findFirstOf(scalar, x, n, separators)) {
+							fail(version.name, "find with several separators", offset, n);
+						}
+					}
+				}
+
+				// Whichever version is selected, splitting finds the first
+				// separator
+				std::string_view token(x, n);
+				std::size_t expected = std::min(token.find_first_of(":="), n);
+				targ::detail::LongToken split = targ::detail::splitLongToken(token, ":=");
+
+				if (split.name.size() != expected || split.hasValue != (expected != n)) {
+					fail("selected", "splitLongToken", offset, n);
+				}
+			}
+		}
+	}
+
+	std::printf("%d mismatches in %zu versions\n", failures, versions.size());
+	return failures != 0;
+}
@@ -0,0 +1,74 @@
+/*
+ * Checks that WindowsParser takes absolute POSIX paths as positional
+ * arguments, as clang-cl does, while still matching its options.
+ *
+ * Build and run from the repository root:
+ *	g++ -std=c++20 -O2 -I. -o windows_paths tests/windows_paths.cpp
+ *	./windows_paths
+ * It prints each failure and exits with a nonzero status if there are any.
+ */
+#include <cstdio>
+#include <string_view>
+#include <vector>
+
+#include "targ.hpp"
+#include "windows.hpp"
+
+namespace {
+	// Arguments whose values can be read back
+	template <typename T>
+	struct Option : targ::Option<T> {
+		using targ::Option<T>::Option;
+		using targ::Option<T>::value;
+	};
+
+	template <typename T>
+	struct Positional : targ::PositionalArgument<T> {
+		using targ::PositionalArgument<T>::PositionalArgument;
+		using targ::PositionalArgument<T>::value;
+	};
+
+	struct Compiler : targ::WindowsParser {
+		targ::Switch nologo{this, "nologo", "Suppress the banner"};
+		Option<std::vector<std::string_view>> include{this, 'I', "Include directories"};
+		Option<std::string_view> output{this, "Fe", "Output file"};
+		Positional<std::vector<std::string_view>> files{this, "files", "Source files"};
+	};
+
+	int failures = 0;
+
+	void check(bool ok, const char *what) {
+		if (!ok) {
+			std::printf("failed: %s\n", what);
+			++failures;
+		}
+	}
+}
+
+int main() {
+	std::vector<std::string_view> args{"/nologo", "/home/x/a.c", "/I", "/usr/include", "/Fe:/tmp/a.out",
+		"b.c", "/NOLOGO", "/tmp/c:d.c"};
+	Compiler parser;
+	targ::parse(parser, args);
+
+	check(parser.isPresent(parser.nologo), "/nologo is an option");
+	check(parser.files.value == std::vector<std::string_view>{"/home/x/a.c", "b.c", "/tmp/c:d.c"},
+		"absolute paths are positional");
+	check(parser.include.value == std::vector<std::string_view>{"/usr/include"}, "an option takes a path as its value");
+	check(parser.output.value == "/tmp/a.out", "an attached value may be a path");
+
+	// With no positional argument to fill, a path is still unexpected
+	struct Bare : targ::WindowsParser {
+		targ::Switch nologo{this, "nologo", "Suppress the banner"};
+	} bare;
+
+	try {
+		targ::parse(bare, std::vector<std::string_view>{"/home/x/a.c"});
+		check(false, "a path without a positional argument is an error");
+	} catch (const targ::ParsingError &e) {
+		check(std::string_view(e.what()) == "Unexpected argument /home/x/a.c", "the error names the path");
+	}
+
+	std::printf("%d failures\n", failures);
+	return failures != 0;
+}
@@ -4,8 +4,6 @@
 #ifndef _TARG_UNIX_HPP_
 #define _TARG_UNIX_HPP_
 
-#include <typeinfo>
-
 #include "targ.hpp"
 
 namespace targ {
@@ -14,11 +12,24 @@ namespace targ {
 		bool parseOptions = true;
 
 	public:
-		const std::string shortOptPrefix = "-";
-		const std::string longOptPrefix = "--";
+		UnixParser() : AbstractParser(OptionStyle::posix()) {}
+
+		/*
+		 * Construct a parser which allocates from a memory resource
+		 *
+		 * resource		The memory resource to allocate from. It must outlive
+		 * 				the parser.
+		 */
+		explicit UnixParser(std::pmr::memory_resource *resource) : AbstractParser(OptionStyle::posix(), resource) {}
+
+		// -abc is -a -b -c, and -ofile is -o file
+		static constexpr bool clusterShortOptions = true;
 
-		virtual bool metaparser(std::string arg) {
-			if (arg == "--") {
+		// --output=a.out is --output a.out
+		static constexpr std::string_view longValueSeparators = "=";
+
+		virtual bool metaparser(std::string_view arg) {
+			if (parseOptions && arg == "--") {
 				// Stop parsing options
 				parseOptions = false;
 				return true;
@@ -28,12 +39,8 @@ namespace targ {
 		}
 
 		virtual bool shouldTest(AbstractArgument *arg) {
-			if (!parseOptions && typeid(arg->tag) == typeid(positional_tag)) {
-				// Don't parse options
-				return false;
-			}
-
-			return true;
+			// Don't parse options after --
+			return parseOptions || arg->kind != ArgKind::option;
 		}
 	};
 }
@@ -0,0 +1,150 @@
+/*
+ * A base targ parser for windows-style arguments
+ */
+#ifndef _TARG_WINDOWS_HPP_
+#define _TARG_WINDOWS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "targ.hpp"
+
+namespace targ {
+	namespace detail {
+		/*
+		 * FNV-1a hash of a string with ASCII letters folded to lower case, so
+		 * names which differ only in case hash the same
+		 */
+		constexpr std::size_t hashFolded(std::string_view str) {
+			std::size_t hash = 14695981039346656037ull;
+
+			for (char c : str) {
+				hash ^= foldCase(c);
+				hash *= 1099511628211ull;
+			}
+
+			return hash;
+		}
+
+		constexpr bool equalFolded(std::string_view a, std::string_view b) {
+			if (a.size() != b.size()) return false;
+
+			for (std::size_t i = 0; i < a.size(); ++i) {
+				if (foldCase(a[i]) != foldCase(b[i])) return false;
+			}
+
+			return true;
+		}
+	}
+
+	/*
+	 * A parser for windows-style arguments: /opt, /opt:value and /opt=value.
+	 * Option names are matched case-insensitively, through an index of
+	 * case-folded hashes, so tokens are never lowercased into a copy.
+	 *
+	 * Options with a short name are matched by that one letter, e.g. /I; an
+	 * option's short and long names share one namespace. An argument which
+	 * starts with / but names no option is positional, so absolute paths can
+	 * be passed as they are.
+	 */
+	class WindowsParser : public AbstractParser {
+	private:
+		// One entry per name: (argument id << 1 | whether it is the short
+		// name) + 1, or 0 for an empty slot
+		std::pmr::vector<std::uint32_t> foldedSlots;
+		std::size_t foldedCount = 0;
+
+		std::string_view nameOf(std::uint32_t entry) const {
+			std::uint32_t id = (entry - 1) >> 1;
+
+			if ((entry - 1) & 1) return std::string_view(&args.shortNames[id], 1);
+			return args.longName(id);
+		}
+
+		void place(std::uint32_t entry) {
+			std::size_t mask = foldedSlots.size() - 1;
+			std::size_t i = detail::hashFolded(nameOf(entry)) & mask;
+
+			while (foldedSlots[i]) i = (i + 1) & mask;
+			foldedSlots[i] = entry;
+		}
+
+		std::size_t findFolded(std::string_view name) const {
+			if (foldedSlots.empty()) return 0;
+
+			std::size_t mask = foldedSlots.size() - 1;
+			for (std::size_t i = detail::hashFolded(name) & mask; foldedSlots[i]; i = (i + 1) & mask) {
+				if (detail::equalFolded(nameOf(foldedSlots[i]), name)) return foldedSlots[i];
+			}
+
+			return 0;
+		}
+
+		void indexFolded(std::uint32_t entry) {
+			if (findFolded(nameOf(entry))) {
+				throw std::invalid_argument("Duplicate option " + std::string(nameOf(entry)));
+			}
+
+			if ((foldedCount + 1) * 2 > foldedSlots.size()) {
+				std::pmr::vector<std::uint32_t> old = std::move(foldedSlots);
+				foldedSlots.assign(old.empty() ? 16 : old.size() * 2, 0);
+
+				for (std::uint32_t slot : old) {
+					if (slot) place(slot);
+				}
+			}
+
+			place(entry);
+			++foldedCount;
+		}
+
+	protected:
+		virtual void addOption(AbstractArgument *arg, char shortName, std::string_view longName) {
+			AbstractParser::addOption(arg, shortName, longName);
+
+			std::uint32_t id = idOf(arg);
+			if (shortName != '\0') indexFolded((id << 1 | 1) + 1);
+			if (!longName.empty()) indexFolded((id << 1) + 1);
+		}
+
+	public:
+		WindowsParser() : WindowsParser(std::pmr::get_default_resource()) {}
+
+		/*
+		 * Construct a parser which allocates from a memory resource
+		 *
+		 * resource		The memory resource to allocate from. It must outlive
+		 * 				the parser.
+		 */
+		explicit WindowsParser(std::pmr::memory_resource *resource)
+			: AbstractParser(OptionStyle::windows(), resource), foldedSlots(resource) {}
+
+		// /out:a.exe and /out=a.exe are /out a.exe
+		static constexpr std::string_view longValueSeparators = ":=";
+
+		// Abbreviations fold case too, so /VERB abbreviates /verbose
+		static constexpr bool caseInsensitive = true;
+
+		// /home/x/a.c is a file, as clang-cl takes it, unless an option is
+		// named home/x/a.c
+		static constexpr bool unknownLongOptionsArePositional = true;
+
+		/*
+		 * Find the option with a name, ignoring case
+		 *
+		 * name		The name, without its prefix
+		 * Returns the option, or nullptr if there is none.
+		 */
+		AbstractArgument *findLongOption(std::string_view name) const {
+			std::size_t entry = findFolded(name);
+			return entry ? deref(args.refs[(entry - 1) >> 1]) : nullptr;
+		}
+	};
+}
+
+#endif  // _TARG_WINDOWS_HPP_